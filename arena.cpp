@@ -0,0 +1,28 @@
+#include "arena.hpp"
+
+#include <cstdint>
+
+thread_local Arena* Arena::current = nullptr;
+
+void* Arena::allocate(size_t size, size_t align) {
+    uintptr_t p = (reinterpret_cast<uintptr_t>(cur) + align - 1) & ~(uintptr_t)(align - 1);
+    if (!cur || p + size > reinterpret_cast<uintptr_t>(end)) {
+        // nowy blok (duże obiekty dostają własny)
+        size_t bytes = size + align > blockSize ? size + align : blockSize;
+        char* block = static_cast<char*>(::operator new(bytes));
+        blocks.push_back(block);
+        cur = block;
+        end = block + bytes;
+        p = (reinterpret_cast<uintptr_t>(cur) + align - 1) & ~(uintptr_t)(align - 1);
+    }
+    cur = reinterpret_cast<char*>(p + size);
+    used += size;
+    return reinterpret_cast<void*>(p);
+}
+
+void Arena::release() {
+    for (char* block : blocks) ::operator delete(block);
+    blocks.clear();
+    cur = end = nullptr;
+    used = 0;
+}
@@ -0,0 +1,77 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+//////////////////////////////////////
+// Arena (bump allocator) na drzewo programu
+//////////////////////////////////////
+//
+// Węzły AST i ich listy dzieci przydzielane są kolejno z dużych bloków;
+// pojedyncze zwolnienie nic nie robi, całość znika razem z areną (bez
+// przechodzenia destruktorów drzewa). Arena::current wskazuje arenę bieżącej
+// kompilacji w danym wątku i nie może się zmienić, dopóki żyją jej węzły.
+class Arena {
+public:
+    explicit Arena(size_t blockSize = 1 << 16) : blockSize(blockSize) {}
+    ~Arena() { release(); }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    // Zwalnia wszystkie bloki naraz
+    void release();
+
+    size_t bytesUsed() const { return used; }
+
+    static thread_local Arena* current; ///< arena kompilacji wątku (nullptr => zwykły new/delete)
+
+private:
+    std::vector<char*> blocks;
+    char* cur = nullptr;
+    char* end = nullptr;
+    size_t blockSize;
+    size_t used = 0;
+};
+
+// Arena jako Arena::current na czas jednej kompilacji
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena &arena) : saved(Arena::current) { Arena::current = &arena; }
+    ~ArenaScope() { Arena::current = saved; }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    Arena* saved;
+};
+
+// Alokator dla kontenerów w węzłach (listy dzieci) - z Arena::current
+template <class T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    ArenaAllocator() = default;
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        if (Arena::current) return static_cast<T*>(Arena::current->allocate(n * sizeof(T), alignof(T)));
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t) {
+        if (!Arena::current) ::operator delete(p);
+    }
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>&) const { return true; }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>&) const { return false; }
+};
+
+#endif // ARENA_HPP
@@ -6,6 +6,9 @@
 #include <cstdint>
 #include <iostream>
 
+#include "arena.hpp"
+#include "intern.hpp"
+
 // Forward declaration interfejsu
 class ASTVisitor;
 
@@ -21,10 +24,24 @@ public:
 
     uint64_t getLine() const { return line; }
 
+    // Węzły w arenie kompilacji (Arena::current); delete uruchamia destruktor,
+    // a pamięć wraca dopiero z całą areną
+    static void* operator new(size_t size) {
+        return Arena::current ? Arena::current->allocate(size) : ::operator new(size);
+    }
+    static void operator delete(void* p) {
+        if (!Arena::current) ::operator delete(p);
+    }
+
     // Każdy węzeł zdefiniuje accept, który woła visitor.visit(*this)
     virtual void accept(ASTVisitor& visitor) = 0;
 };
 
+// Kontenery w węzłach (w arenie, giną razem z drzewem)
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+using NodeList = ArenaVector<ASTNode*>;
+
 //////////////////////////////////////
 // Deklaracja enumeracji CommandKind
 //////////////////////////////////////
@@ -110,7 +127,7 @@ public:
 //////////////////////////////////////
 class ProceduresNode : public ASTNode {
 public:
-    std::vector<ASTNode*> procedureDecls;
+    NodeList procedureDecls;
 
     ProceduresNode(uint64_t ln)
         : ASTNode(ln) {}
@@ -127,10 +144,10 @@ public:
 //////////////////////////////////////
 class ProcHeadNode : public ASTNode {
 public:
-    std::string procName;
+    Name procName;
     ASTNode* argsDecl; // np. ArgsDeclNode
 
-    ProcHeadNode(uint64_t ln, const std::string& name, ASTNode* args)
+    ProcHeadNode(uint64_t ln, Name name, ASTNode* args)
         : ASTNode(ln), procName(name), argsDecl(args) {}
     ~ProcHeadNode() override {
         delete argsDecl;
@@ -145,13 +162,13 @@ public:
 //////////////////////////////////////
 class ProcedureDeclNode : public ASTNode {
 public:
-    std::string procName;
+    Name procName;
     ASTNode* argsDecl;   // ArgsDeclNode
     ASTNode* localDecls; // DeclarationsNode
     ASTNode* commands;   // CommandsNode
 
     ProcedureDeclNode(uint64_t ln,
-                      const std::string &pName,
+                      Name pName,
                       ASTNode* args,
                       ASTNode* decls,
                       ASTNode* cmds)
@@ -193,7 +210,7 @@ public:
 //////////////////////////////////////
 class DeclarationsNode : public ASTNode {
 public:
-    std::vector<ASTNode*> declList; // DeclarationVarNode lub DeclarationArrNode
+    NodeList declList; // DeclarationVarNode lub DeclarationArrNode
 
     DeclarationsNode(uint64_t ln)
         : ASTNode(ln) {}
@@ -210,9 +227,9 @@ public:
 //////////////////////////////////////
 class DeclarationVarNode : public ASTNode {
 public:
-    std::string varName;
+    Name varName;
 
-    DeclarationVarNode(uint64_t ln, const std::string &nm)
+    DeclarationVarNode(uint64_t ln, Name nm)
         : ASTNode(ln), varName(nm) {}
 
     void accept(ASTVisitor& visitor) override {
@@ -225,12 +242,12 @@ public:
 //////////////////////////////////////
 class DeclarationArrNode : public ASTNode {
 public:
-    std::string arrName;
+    Name arrName;
     long long lowerBound;
     long long upperBound;
 
     DeclarationArrNode(uint64_t ln,
-                       const std::string &nm,
+                       Name nm,
                        long long lb, long long ub)
         : ASTNode(ln), arrName(nm), lowerBound(lb), upperBound(ub) {}
 
@@ -244,7 +261,7 @@ public:
 //////////////////////////////////////
 class CommandsNode : public ASTNode {
 public:
-    std::vector<ASTNode*> cmdList; // CommandNode
+    NodeList cmdList; // CommandNode
 
     CommandsNode(uint64_t ln)
         : ASTNode(ln) {}
@@ -262,7 +279,7 @@ public:
 class CommandNode : public ASTNode {
 public:
     CommandKind cmdKind;
-    std::vector<ASTNode*> children; // np. [ IdentifierNode, ExpressionNode ]
+    NodeList children; // np. [ IdentifierNode, ExpressionNode ]
 
     CommandNode(uint64_t ln, CommandKind ck)
         : ASTNode(ln), cmdKind(ck) {}
@@ -279,8 +296,8 @@ public:
 //////////////////////////////////////
 class ArgsDeclNode : public ASTNode {
 public:
-    std::vector<std::string> argNames;
-    std::vector<bool> isArray; // param jest tablicowy (T) lub nie
+    ArenaVector<Name> argNames;
+    ArenaVector<bool> isArray; // param jest tablicowy (T) lub nie
 
     ArgsDeclNode(uint64_t ln)
         : ASTNode(ln) {}
@@ -294,7 +311,7 @@ public:
 //////////////////////////////////////
 class ArgsNode : public ASTNode {
 public:
-    std::vector<std::string> varNames; // nazwy przekazywanych parametrów
+    ArenaVector<Name> varNames; // nazwy przekazywanych parametrów
 
     ArgsNode(uint64_t ln)
         : ASTNode(ln) {}
@@ -308,14 +325,14 @@ public:
 //////////////////////////////////////
 class ProcCallNode : public ASTNode {
 public:
-    std::string procName;
+    Name procName;
     ASTNode* args; // np. ArgsNode
 
-    ProcCallNode(uint64_t ln, const std::string& nm, ASTNode* a)
+    ProcCallNode(uint64_t ln, Name nm, ASTNode* a)
         : ASTNode(ln), procName(nm), args(a) {}
 
     // Konstruktor, gdy brak wskaźnika do args
-    ProcCallNode(uint64_t ln, const std::string& nm)
+    ProcCallNode(uint64_t ln, Name nm)
         : ASTNode(ln), procName(nm), args(nullptr) {}
 
     ~ProcCallNode() override {
@@ -374,10 +391,11 @@ public:
 //////////////////////////////////////
 class IdentifierNode : public ASTNode {
 public:
-    std::string name;
+    Name name;
     ASTNode* indexExpr; // nullptr, jeśli to zwykła zmienna
+    int sym = -1;       // indeks w SymbolTable::symbols (ustawia analiza semantyczna), -1 => brak
 
-    IdentifierNode(uint64_t ln, const std::string &nm, ASTNode* idx)
+    IdentifierNode(uint64_t ln, Name nm, ASTNode* idx)
         : ASTNode(ln), name(nm), indexExpr(idx) {}
 
     ~IdentifierNode() override {
@@ -0,0 +1,422 @@
+#include "ast_opt.hpp"
+
+#include <climits>
+#include <vector>
+
+// ------------------ Arytmetyka ------------------
+
+bool evalBinary(const std::string &op, long long a, long long b, long long &result) {
+    if (op == "+") return !__builtin_add_overflow(a, b, &result);
+    if (op == "-") return !__builtin_sub_overflow(a, b, &result);
+    if (op == "*") return !__builtin_mul_overflow(a, b, &result);
+    if (op == "/" || op == "%") {
+        if (b == 0) {
+            result = 0;
+            return true;
+        }
+        if (a == LLONG_MIN && b == -1) return false;
+        if (op == "/") {
+            result = a / b;
+            if (a % b != 0 && ((a < 0) != (b < 0))) result--;
+        } else {
+            result = a % b;
+            if (result != 0 && ((result < 0) != (b < 0))) result += b;
+        }
+        return true;
+    }
+    if (op == "==") { result = (a == b); return true; }
+    if (op == "!=") { result = (a != b); return true; }
+    if (op == "<")  { result = (a < b);  return true; }
+    if (op == ">")  { result = (a > b);  return true; }
+    if (op == "<=") { result = (a <= b); return true; }
+    if (op == ">=") { result = (a >= b); return true; }
+    return false;
+}
+
+// ------------------ Kopia / rozmiar ------------------
+
+ASTNode* cloneAST(const ASTNode* node) {
+    if (!node) return nullptr;
+
+    if (auto* pan = dynamic_cast<const ProgramAllNode*>(node)) {
+        return new ProgramAllNode(pan->getLine(), cloneAST(pan->procedures), cloneAST(pan->mainPart));
+    }
+    if (auto* procs = dynamic_cast<const ProceduresNode*>(node)) {
+        auto* copy = new ProceduresNode(procs->getLine());
+        for (auto* p : procs->procedureDecls) copy->procedureDecls.push_back(cloneAST(p));
+        return copy;
+    }
+    if (auto* ph = dynamic_cast<const ProcHeadNode*>(node)) {
+        return new ProcHeadNode(ph->getLine(), ph->procName, cloneAST(ph->argsDecl));
+    }
+    if (auto* pd = dynamic_cast<const ProcedureDeclNode*>(node)) {
+        return new ProcedureDeclNode(pd->getLine(), pd->procName, cloneAST(pd->argsDecl),
+                                     cloneAST(pd->localDecls), cloneAST(pd->commands));
+    }
+    if (auto* mn = dynamic_cast<const MainNode*>(node)) {
+        return new MainNode(mn->getLine(), cloneAST(mn->declarations), cloneAST(mn->commands));
+    }
+    if (auto* decls = dynamic_cast<const DeclarationsNode*>(node)) {
+        auto* copy = new DeclarationsNode(decls->getLine());
+        for (auto* d : decls->declList) copy->declList.push_back(cloneAST(d));
+        return copy;
+    }
+    if (auto* dv = dynamic_cast<const DeclarationVarNode*>(node)) {
+        return new DeclarationVarNode(dv->getLine(), dv->varName);
+    }
+    if (auto* da = dynamic_cast<const DeclarationArrNode*>(node)) {
+        return new DeclarationArrNode(da->getLine(), da->arrName, da->lowerBound, da->upperBound);
+    }
+    if (auto* cmds = dynamic_cast<const CommandsNode*>(node)) {
+        auto* copy = new CommandsNode(cmds->getLine());
+        for (auto* c : cmds->cmdList) copy->cmdList.push_back(cloneAST(c));
+        return copy;
+    }
+    if (auto* cmd = dynamic_cast<const CommandNode*>(node)) {
+        auto* copy = new CommandNode(cmd->getLine(), cmd->cmdKind);
+        for (auto* c : cmd->children) copy->children.push_back(cloneAST(c));
+        return copy;
+    }
+    if (auto* ad = dynamic_cast<const ArgsDeclNode*>(node)) {
+        auto* copy = new ArgsDeclNode(ad->getLine());
+        copy->argNames = ad->argNames;
+        copy->isArray = ad->isArray;
+        return copy;
+    }
+    if (auto* an = dynamic_cast<const ArgsNode*>(node)) {
+        auto* copy = new ArgsNode(an->getLine());
+        copy->varNames = an->varNames;
+        return copy;
+    }
+    if (auto* pc = dynamic_cast<const ProcCallNode*>(node)) {
+        return new ProcCallNode(pc->getLine(), pc->procName, cloneAST(pc->args));
+    }
+    if (auto* expr = dynamic_cast<const ExpressionNode*>(node)) {
+        return new ExpressionNode(expr->getLine(), expr->op, cloneAST(expr->left), cloneAST(expr->right));
+    }
+    if (auto* val = dynamic_cast<const ValueNode*>(node)) {
+        return new ValueNode(val->getLine(), val->val);
+    }
+    if (auto* idn = dynamic_cast<const IdentifierNode*>(node)) {
+        auto* copy = new IdentifierNode(idn->getLine(), idn->name, cloneAST(idn->indexExpr));
+        copy->sym = idn->sym;
+        return copy;
+    }
+    return nullptr;
+}
+
+long long countNodes(const ASTNode* node) {
+    if (!node) return 0;
+    long long n = 1;
+    if (auto* cmds = dynamic_cast<const CommandsNode*>(node)) {
+        for (auto* c : cmds->cmdList) n += countNodes(c);
+    } else if (auto* cmd = dynamic_cast<const CommandNode*>(node)) {
+        for (auto* c : cmd->children) n += countNodes(c);
+    } else if (auto* pd = dynamic_cast<const ProcedureDeclNode*>(node)) {
+        n += countNodes(pd->argsDecl) + countNodes(pd->localDecls) + countNodes(pd->commands);
+    } else if (auto* decls = dynamic_cast<const DeclarationsNode*>(node)) {
+        n += decls->declList.size();
+    } else if (auto* pc = dynamic_cast<const ProcCallNode*>(node)) {
+        n += countNodes(pc->args);
+    } else if (auto* expr = dynamic_cast<const ExpressionNode*>(node)) {
+        n += countNodes(expr->left) + countNodes(expr->right);
+    } else if (auto* idn = dynamic_cast<const IdentifierNode*>(node)) {
+        n += countNodes(idn->indexExpr);
+    }
+    return n;
+}
+
+void collectAssigned(const ASTNode* node, std::set<Name> &out) {
+    if (!node) return;
+    if (auto* cmds = dynamic_cast<const CommandsNode*>(node)) {
+        for (auto* c : cmds->cmdList) collectAssigned(c, out);
+        return;
+    }
+    auto* cmd = dynamic_cast<const CommandNode*>(node);
+    if (!cmd) return;
+
+    switch (cmd->cmdKind) {
+    case CommandKind::ASSIGN:
+    case CommandKind::READ: {
+        auto* target = dynamic_cast<IdentifierNode*>(cmd->children[0]);
+        if (target && !target->indexExpr) out.insert(target->name);
+        break;
+    }
+    case CommandKind::PROC_CALL: {
+        auto* pc = dynamic_cast<ProcCallNode*>(cmd->children[0]);
+        auto* an = pc ? dynamic_cast<ArgsNode*>(pc->args) : nullptr;
+        if (an) out.insert(an->varNames.begin(), an->varNames.end());
+        break;
+    }
+    default:
+        for (auto* c : cmd->children) collectAssigned(c, out);
+    }
+}
+
+// ------------------ Stan procedury między wywołaniami ------------------
+
+namespace {
+
+// Przepływ w przód: zmienne lokalne na pewno już przypisane w tym wywołaniu
+class LocalStateScan {
+public:
+    std::set<Name> scalars, arrays; ///< deklaracje lokalne procedury
+    bool exposed = false;           ///< odczyt wartości z poprzedniego wywołania
+
+    void reads(const ASTNode* node, const std::set<Name> &assigned) {
+        if (auto* idn = dynamic_cast<const IdentifierNode*>(node)) {
+            if (arrays.count(idn->name)) exposed = true;
+            else if (!idn->indexExpr && scalars.count(idn->name) && !assigned.count(idn->name)) exposed = true;
+            reads(idn->indexExpr, assigned);
+        } else if (auto* expr = dynamic_cast<const ExpressionNode*>(node)) {
+            reads(expr->left, assigned);
+            reads(expr->right, assigned);
+        }
+    }
+
+    // Cel przypisania / READ: czytany jest tylko indeks
+    void writes(const ASTNode* node, std::set<Name> &assigned) {
+        auto* idn = dynamic_cast<const IdentifierNode*>(node);
+        if (!idn) return;
+        if (idn->indexExpr) reads(idn->indexExpr, assigned);
+        else assigned.insert(idn->name);
+    }
+
+    void commands(const ASTNode* node, std::set<Name> &assigned) {
+        auto* cmds = dynamic_cast<const CommandsNode*>(node);
+        if (!cmds) return;
+        for (auto* c : cmds->cmdList) {
+            if (auto* cmd = dynamic_cast<const CommandNode*>(c)) command(cmd, assigned);
+        }
+    }
+
+    void command(const CommandNode* cmd, std::set<Name> &assigned) {
+        switch (cmd->cmdKind) {
+        case CommandKind::ASSIGN:
+            reads(cmd->children[1], assigned);
+            writes(cmd->children[0], assigned);
+            break;
+        case CommandKind::READ:
+            writes(cmd->children[0], assigned);
+            break;
+        case CommandKind::WRITE:
+            reads(cmd->children[0], assigned);
+            break;
+        case CommandKind::PROC_CALL: {
+            // copy-in czyta argumenty, copy-out je przypisuje
+            auto* pc = dynamic_cast<const ProcCallNode*>(cmd->children[0]);
+            auto* an = pc ? dynamic_cast<const ArgsNode*>(pc->args) : nullptr;
+            if (!an) break;
+            for (auto &name : an->varNames) {
+                if (arrays.count(name) || (scalars.count(name) && !assigned.count(name))) exposed = true;
+            }
+            assigned.insert(an->varNames.begin(), an->varNames.end());
+            break;
+        }
+        case CommandKind::IF_THEN:
+        case CommandKind::IF_THEN_ELSE: {
+            reads(cmd->children[0], assigned);
+            std::set<Name> thenAssigned = assigned, elseAssigned = assigned;
+            commands(cmd->children[1], thenAssigned);
+            if (cmd->cmdKind == CommandKind::IF_THEN_ELSE) commands(cmd->children[2], elseAssigned);
+            assigned.clear();
+            for (auto &name : thenAssigned) {
+                if (elseAssigned.count(name)) assigned.insert(name);
+            }
+            break;
+        }
+        case CommandKind::WHILE: {
+            // ciało może się nie wykonać => po pętli to, co przed nią
+            reads(cmd->children[0], assigned);
+            std::set<Name> body = assigned;
+            commands(cmd->children[1], body);
+            break;
+        }
+        case CommandKind::REPEAT_UNTIL:
+            commands(cmd->children[0], assigned);
+            reads(cmd->children[1], assigned);
+            break;
+        case CommandKind::FOR_UP:
+        case CommandKind::FOR_DOWN: {
+            reads(cmd->children[1], assigned);
+            reads(cmd->children[2], assigned);
+            std::set<Name> body = assigned;
+            commands(cmd->children[3], body);
+            break;
+        }
+        }
+    }
+};
+
+} // namespace
+
+bool keepsStateBetweenCalls(const ProcedureDeclNode* proc) {
+    LocalStateScan scan;
+    if (auto* decls = dynamic_cast<const DeclarationsNode*>(proc->localDecls)) {
+        for (auto* d : decls->declList) {
+            if (auto* dv = dynamic_cast<const DeclarationVarNode*>(d)) scan.scalars.insert(dv->varName);
+            else if (auto* da = dynamic_cast<const DeclarationArrNode*>(d)) scan.arrays.insert(da->arrName);
+        }
+    }
+    std::set<Name> assigned;
+    scan.commands(proc->commands, assigned);
+    return scan.exposed;
+}
+
+// ------------------ Podstawianie stałych ------------------
+
+ASTNode* substituteConstants(ASTNode* node, const ConstFacts &facts) {
+    if (!node || facts.empty()) return node;
+
+    if (auto* idn = dynamic_cast<IdentifierNode*>(node)) {
+        if (!idn->indexExpr) {
+            auto it = facts.find(idn->name);
+            if (it == facts.end()) return node;
+            ASTNode* lit = new ValueNode(idn->getLine(), it->second);
+            delete idn;
+            return lit;
+        }
+        idn->indexExpr = substituteConstants(idn->indexExpr, facts);
+        return node;
+    }
+    if (auto* expr = dynamic_cast<ExpressionNode*>(node)) {
+        expr->left = substituteConstants(expr->left, facts);
+        expr->right = substituteConstants(expr->right, facts);
+        return node;
+    }
+    if (auto* cmds = dynamic_cast<CommandsNode*>(node)) {
+        for (auto* &c : cmds->cmdList) c = substituteConstants(c, facts);
+        return node;
+    }
+    auto* cmd = dynamic_cast<CommandNode*>(node);
+    if (!cmd) return node;
+
+    switch (cmd->cmdKind) {
+    case CommandKind::ASSIGN:
+    case CommandKind::READ: {
+        // cel zostaje, podstawiamy tylko w indeksie i wyrażeniu
+        auto* target = dynamic_cast<IdentifierNode*>(cmd->children[0]);
+        if (target) target->indexExpr = substituteConstants(target->indexExpr, facts);
+        for (size_t i = 1; i < cmd->children.size(); i++)
+            cmd->children[i] = substituteConstants(cmd->children[i], facts);
+        break;
+    }
+    case CommandKind::FOR_UP:
+    case CommandKind::FOR_DOWN: {
+        // iterator przesłania zmienną o tej samej nazwie w ciele
+        auto* iter = dynamic_cast<IdentifierNode*>(cmd->children[0]);
+        cmd->children[1] = substituteConstants(cmd->children[1], facts);
+        cmd->children[2] = substituteConstants(cmd->children[2], facts);
+        ConstFacts inner = facts;
+        if (iter) inner.erase(iter->name);
+        cmd->children[3] = substituteConstants(cmd->children[3], inner);
+        break;
+    }
+    case CommandKind::PROC_CALL:
+        break; // argumenty to nazwy zmiennych (IN-OUT)
+    default:
+        for (auto* &c : cmd->children) c = substituteConstants(c, facts);
+    }
+    return node;
+}
+
+// ------------------ Zwijanie ------------------
+
+ASTNode* foldExpression(ASTNode* node) {
+    if (auto* idn = dynamic_cast<IdentifierNode*>(node)) {
+        if (idn->indexExpr) idn->indexExpr = foldExpression(idn->indexExpr);
+        return node;
+    }
+    auto* expr = dynamic_cast<ExpressionNode*>(node);
+    if (!expr) return node;
+
+    expr->left = foldExpression(expr->left);
+    expr->right = foldExpression(expr->right);
+    auto* lv = dynamic_cast<ValueNode*>(expr->left);
+    auto* rv = dynamic_cast<ValueNode*>(expr->right);
+
+    long long r;
+    if (lv && rv && evalBinary(expr->op, lv->val, rv->val, r)) {
+        ASTNode* lit = new ValueNode(expr->getLine(), r);
+        delete expr;
+        return lit;
+    }
+
+    // Tożsamości: x+0, 0+x, x-0, x*1, 1*x, x/1
+    ASTNode* keep = nullptr;
+    if ((expr->op == "+" || expr->op == "-") && rv && rv->val == 0) keep = expr->left;
+    else if (expr->op == "+" && lv && lv->val == 0)                 keep = expr->right;
+    else if ((expr->op == "*" || expr->op == "/") && rv && rv->val == 1) keep = expr->left;
+    else if (expr->op == "*" && lv && lv->val == 1)                 keep = expr->right;
+    if (keep) {
+        if (keep == expr->left) expr->left = nullptr;
+        else expr->right = nullptr;
+        delete expr;
+        return keep;
+    }
+    return node;
+}
+
+void simplifyCommands(CommandsNode* cmds) {
+    if (!cmds) return;
+    NodeList result;
+
+    // Przenosi komendy gałęzi do wyniku (gałąź zostaje pusta)
+    auto splice = [&result](ASTNode* branch) {
+        auto* body = dynamic_cast<CommandsNode*>(branch);
+        if (!body) return;
+        result.insert(result.end(), body->cmdList.begin(), body->cmdList.end());
+        body->cmdList.clear();
+    };
+
+    for (auto* c : cmds->cmdList) {
+        auto* cmd = dynamic_cast<CommandNode*>(c);
+        if (!cmd) {
+            result.push_back(c);
+            continue;
+        }
+
+        // zwijamy wyrażenia, schodzimy do zagnieżdżonych bloków
+        for (auto* &child : cmd->children) {
+            if (auto* inner = dynamic_cast<CommandsNode*>(child)) simplifyCommands(inner);
+            else child = foldExpression(child);
+        }
+
+        switch (cmd->cmdKind) {
+        case CommandKind::IF_THEN:
+        case CommandKind::IF_THEN_ELSE: {
+            auto* cond = dynamic_cast<ValueNode*>(cmd->children[0]);
+            if (!cond) break;
+            if (cond->val != 0) splice(cmd->children[1]);
+            else if (cmd->cmdKind == CommandKind::IF_THEN_ELSE) splice(cmd->children[2]);
+            delete cmd;
+            cmd = nullptr;
+            break;
+        }
+        case CommandKind::WHILE: {
+            auto* cond = dynamic_cast<ValueNode*>(cmd->children[0]);
+            if (cond && cond->val == 0) {
+                delete cmd;
+                cmd = nullptr;
+            }
+            break;
+        }
+        case CommandKind::FOR_UP:
+        case CommandKind::FOR_DOWN: {
+            auto* from = dynamic_cast<ValueNode*>(cmd->children[1]);
+            auto* to = dynamic_cast<ValueNode*>(cmd->children[2]);
+            bool empty = from && to &&
+                (cmd->cmdKind == CommandKind::FOR_UP ? from->val > to->val : from->val < to->val);
+            if (empty) {
+                delete cmd;
+                cmd = nullptr;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        if (cmd) result.push_back(cmd);
+    }
+    cmds->cmdList = result;
+}
@@ -0,0 +1,48 @@
+#ifndef AST_OPT_HPP
+#define AST_OPT_HPP
+
+#include "ast.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+
+//////////////////////////////////////
+// Narzędzia do przekształceń AST (wspólne dla optymalizacji)
+//////////////////////////////////////
+
+// Znane stałe wartości zwykłych zmiennych: nazwa => wartość
+using ConstFacts = std::map<Name, long long>;
+
+// Arytmetyka/porównanie jak na maszynie: dzielenie w dół, reszta ze znakiem
+// dzielnika, /0 i %0 => 0. false => przepełnienie (lub nieznany operator).
+bool evalBinary(const std::string &op, long long a, long long b, long long &result);
+
+// Głęboka kopia poddrzewa
+ASTNode* cloneAST(const ASTNode* node);
+
+// Liczba węzłów poddrzewa (miara rozmiaru kodu)
+long long countNodes(const ASTNode* node);
+
+// Nazwy zwykłych zmiennych, które poddrzewo może zmienić:
+// cele przypisań i READ oraz argumenty wywołań (parametry IN-OUT)
+void collectAssigned(const ASTNode* node, std::set<Name> &out);
+
+// Czy procedura może przenieść wartość z jednego wywołania do następnego.
+// Zmienne lokalne są statyczne (jedna komórka na procedurę), więc tak jest,
+// gdy któraś zwykła zmienna lokalna bywa czytana, zanim na każdej ścieżce
+// od początku ciała zostanie przypisana, albo lokalna tablica jest czytana
+// lub przekazywana dalej. Klonowanie i scalanie takiej procedury rozdzieliłoby
+// albo złączyło jej stan.
+bool keepsStateBetweenCalls(const ProcedureDeclNode* proc);
+
+// Zastępuje odczyty zmiennych z facts literałami; zwraca (być może nowy) węzeł
+ASTNode* substituteConstants(ASTNode* node, const ConstFacts &facts);
+
+// Zwija wyrażenia o stałych operandach; zwraca (być może nowy) węzeł
+ASTNode* foldExpression(ASTNode* node);
+
+// Zwija wyrażenia i usuwa martwe gałęzie (IF/WHILE/FOR o stałym warunku)
+void simplifyCommands(CommandsNode* cmds);
+
+#endif // AST_OPT_HPP
@@ -0,0 +1,123 @@
+#include "batch.hpp"
+#include "compiler.hpp"
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct BatchJob {
+    std::string src;
+    std::string out;
+};
+
+std::string defaultOutput(const std::string &src) {
+    return fs::path(src).replace_extension(".mr").string();
+}
+
+// Katalog => wszystkie *.imp (po nazwie, żeby kolejność była powtarzalna)
+bool listDirectory(const std::string &dir, std::vector<BatchJob> &jobs) {
+    std::error_code ec;
+    fs::directory_iterator it(dir, ec);
+    if (ec) return false;
+    for (const auto &entry : it) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".imp") continue;
+        std::string src = entry.path().string();
+        jobs.push_back({src, defaultOutput(src)});
+    }
+    std::sort(jobs.begin(), jobs.end(),
+              [](const BatchJob &a, const BatchJob &b) { return a.src < b.src; });
+    return true;
+}
+
+// Manifest: "źródło [wynik]" w linii
+bool readManifest(const std::string &path, std::vector<BatchJob> &jobs) {
+    std::ifstream in(path);
+    if (!in.is_open()) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream ls(line);
+        BatchJob job;
+        if (!(ls >> job.src) || job.src[0] == '#') continue;
+        if (!(ls >> job.out)) job.out = defaultOutput(job.src);
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+// Jak compileProgram, ale źródło kopiowane do bufora, nie mapowane: plik
+// skrócony przez kogoś innego w trakcie wsadu nie może zabić całego
+// procesu sygnałem SIGBUS, najwyżej ten jeden plik się nie skompiluje
+int compileFile(const BatchJob &job, const CompileOptions &opts,
+                std::ostream &log, std::ostream &err) {
+    MappedFile src;
+    if (!src.read(job.src)) {
+        err << "Nie można otworzyć pliku " << job.src << "\n";
+        return 2;
+    }
+    Code code;
+    int res = compileSource(src.data(), src.size(), opts, code, log, err);
+    if (res != 0) return res;
+    return writeCode(job.out, code, log, err);
+}
+
+} // namespace
+
+int compileBatch(const std::string &path, const CompileOptions &opts) {
+    std::vector<BatchJob> jobs;
+    bool listed = fs::is_directory(path) ? listDirectory(path, jobs) : readManifest(path, jobs);
+    if (!listed) {
+        std::cerr << "Nie można odczytać listy plików " << path << "\n";
+        return 2;
+    }
+
+    // Równoległość na poziomie plików; w obrębie pliku generacja jednowątkowa
+    CompileOptions fileOpts = opts;
+    fileOpts.jobs = 1;
+
+    auto start = std::chrono::steady_clock::now();
+    std::mutex outMutex;
+    std::atomic<size_t> failed{0};
+    {
+        WorkStealingPool pool(opts.jobs);
+        for (const BatchJob &job : jobs) {
+            pool.submit([&, job]() {
+                std::ostringstream log, err;
+                int res;
+                try {
+                    res = compileFile(job, fileOpts, log, err);
+                } catch (const std::exception &e) {
+                    err << "Wyjątek: " << e.what() << "\n";
+                    res = 1;
+                }
+                if (res != 0) failed++;
+
+                // Pełne komunikaty tylko przy błędzie: przy tysiącach plików OK wystarczy jedna linia
+                std::lock_guard<std::mutex> lk(outMutex);
+                if (res == 0) {
+                    std::cout << "OK   " << job.src << " => " << job.out << "\n";
+                } else {
+                    std::cerr << "BŁĄD " << job.src << " (kod " << res << ")\n"
+                              << log.str() << err.str();
+                }
+            });
+        }
+        pool.wait();
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Skompilowano " << (jobs.size() - failed) << "/" << jobs.size()
+              << " plików, błędów: " << failed << ", czas " << secs << " s\n";
+    return failed > 0 ? 7 : 0;
+}
@@ -0,0 +1,23 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include "options.hpp"
+
+#include <string>
+
+//////////////////////////////////////
+// Tryb wsadowy: wiele kompilacji w jednym procesie
+//////////////////////////////////////
+//
+// `path` to katalog (kompilujemy każdy *.imp do pliku o tej samej nazwie
+// z rozszerzeniem .mr) albo manifest: w każdej linii "źródło [wynik]",
+// puste linie i linie od '#' pomijane, brak wyniku => źródło z .mr.
+// Pliki kompilowane współbieżnie na puli z podkradaniem zadań
+// (opts.jobs wątków, generacja kodu w każdym pliku jednowątkowo).
+// Komunikaty każdego pliku wypisywane jednym blokiem, na końcu podsumowanie.
+//
+// Wynik: 0 => wszystkie OK, 7 => któryś plik się nie skompilował,
+// 2 => nie da się odczytać manifestu/katalogu.
+int compileBatch(const std::string &path, const CompileOptions &opts);
+
+#endif // BATCH_HPP
@@ -0,0 +1,294 @@
+#include "code_folding.hpp"
+
+#include <sstream>
+
+// ------------------ Reprezentacja robocza ------------------
+
+namespace {
+
+enum class OperandKind {
+    NONE,      // HALF, HALT
+    VALUE,     // SET stała
+    MEMORY,    // LOAD/STORE/ADD/... adres komórki
+    JUMP,      // skok względny (trzymamy cel bezwzględny)
+    CODE_ADDR, // SET adres powrotu
+    MEM_ADDR   // SET adres tablicy
+};
+
+struct Line {
+    Op op = Op::HALT;
+    long long arg = 0;
+    OperandKind kind = OperandKind::NONE;
+    long long target = 0;  // JUMP / CODE_ADDR: bezwzględny adres kodu
+    long long anchor = 0;  // MEM_ADDR: pierwsza komórka tablicy
+    bool deleted = false;
+};
+
+bool inRange(long long x, long long lo, long long hi) {
+    return x >= lo && x < hi;
+}
+
+class Folder {
+public:
+    Folder(const Code &instructions, const CodeLayout &layout)
+        : layout(layout) {
+        code.resize(instructions.size());
+        redirect.assign(instructions.size(), -1);
+        for (size_t i = 0; i < instructions.size(); i++) {
+            Line &in = code[i];
+            in.op = instructions[i].op;
+            in.arg = instructions[i].arg;
+            if (!hasOperand(in.op)) continue;
+
+            if (isJumpOp(in.op)) {
+                in.kind = OperandKind::JUMP;
+                in.target = (long long)i + in.arg;
+            } else if (isMemoryOp(in.op)) {
+                in.kind = OperandKind::MEMORY;
+            } else if (layout.codeAddrSets.count(i)) {
+                in.kind = OperandKind::CODE_ADDR;
+                in.target = in.arg;
+            } else if (layout.memAddrSets.count(i)) {
+                in.kind = OperandKind::MEM_ADDR;
+                in.anchor = layout.memAddrSets.at(i);
+            } else {
+                in.kind = OperandKind::VALUE;
+            }
+        }
+    }
+
+    long long dropDeadStores();
+    long long foldProcedures();
+    long long mergeTails();
+    void threadJumps();
+    void encode(Code &instructions);
+
+private:
+    const CodeLayout &layout;
+    std::vector<Line> code;
+    std::vector<long long> redirect; // usunięta linia => równoważna linia (ciągi się kończą)
+
+    long long resolve(long long t) const {
+        while (t >= 0 && t < (long long)code.size() && code[t].deleted) t = redirect[t];
+        return t;
+    }
+
+    bool same(const Line &a, const Line &b) const {
+        if (a.op != b.op || a.kind != b.kind) return false;
+        if (a.kind == OperandKind::JUMP || a.kind == OperandKind::CODE_ADDR)
+            return resolve(a.target) == resolve(b.target);
+        return a.arg == b.arg;
+    }
+
+    std::string signature(const ProcRange &p) const;
+    void mergeProc(const ProcRange &keep, const ProcRange &drop);
+};
+
+// ------------------ Martwe zapisy do komórek roboczych ------------------
+
+long long Folder::dropDeadStores() {
+    // Komórka robocza jest czytana tylko wprost (LOAD/ADD/SUB/...), więc brak
+    // takiego odczytu w całym kodzie => każdy STORE do niej jest zbędny
+    std::set<long long> read;
+    for (auto &in : code) {
+        if (in.kind == OperandKind::MEMORY && in.op != Op::STORE && in.op != Op::GET) read.insert(in.arg);
+    }
+    long long removed = 0;
+    for (size_t i = 0; i < code.size(); i++) {
+        Line &in = code[i];
+        if (in.op != Op::STORE || !layout.tempCells.count(in.arg) || read.count(in.arg)) continue;
+        in.deleted = true;
+        redirect[i] = i + 1; // skok tutaj => dalej, jak po STORE
+        removed++;
+    }
+    return removed;
+}
+
+// ------------------ Identyczne procedury ------------------
+
+// Postać kanoniczna: własne komórki i własny kod względem początku przedziału
+std::string Folder::signature(const ProcRange &p) const {
+    std::ostringstream os;
+    os << (p.memHi - p.memLo) << '|';
+    for (long long i = p.codeStart; i < p.codeEnd; i++) {
+        const Line &in = code[i];
+        if (in.deleted) continue;
+        os << opName(in.op) << ' ';
+        switch (in.kind) {
+        case OperandKind::MEMORY:
+            if (inRange(in.arg, p.memLo, p.memHi)) os << 'm' << in.arg - p.memLo;
+            else os << in.arg;
+            break;
+        case OperandKind::JUMP:
+        case OperandKind::CODE_ADDR: {
+            long long t = resolve(in.target);
+            if (inRange(t, p.codeStart, p.codeEnd)) os << 'r' << t - p.codeStart;
+            else os << 'a' << t;
+            break;
+        }
+        case OperandKind::MEM_ADDR:
+            if (inRange(in.anchor, p.memLo, p.memHi))
+                os << 'm' << in.anchor - p.memLo << ',' << in.arg - in.anchor;
+            else os << in.arg;
+            break;
+        case OperandKind::VALUE:
+            os << in.arg;
+            break;
+        case OperandKind::NONE:
+            break;
+        }
+        os << ';';
+    }
+    return os.str();
+}
+
+void Folder::mergeProc(const ProcRange &keep, const ProcRange &drop) {
+    // Wywołania drop używają odtąd komórek keep (ten sam układ pamięci)
+    long long delta = keep.memLo - drop.memLo;
+    for (auto &in : code) {
+        if (in.deleted) continue;
+        if (in.kind == OperandKind::MEMORY && inRange(in.arg, drop.memLo, drop.memHi)) {
+            in.arg += delta;
+        } else if (in.kind == OperandKind::MEM_ADDR && inRange(in.anchor, drop.memLo, drop.memHi)) {
+            in.arg += delta;
+            in.anchor += delta;
+        }
+    }
+    for (long long p = drop.codeStart; p < drop.codeEnd; p++) {
+        code[p].deleted = true;
+        redirect[p] = keep.codeStart + (p - drop.codeStart);
+    }
+}
+
+long long Folder::foldProcedures() {
+    long long removed = 0;
+    std::vector<bool> alive(layout.procs.size(), true);
+    bool changed = true;
+    // Scalenie może zrównać wołające je procedury => do punktu stałego
+    while (changed) {
+        changed = false;
+        std::map<std::string, size_t> seen;
+        for (size_t k = 0; k < layout.procs.size() && !changed; k++) {
+            const ProcRange &p = layout.procs[k];
+            if (!alive[k] || p.keepsState) continue;
+            auto res = seen.insert({signature(p), k});
+            if (res.second) continue;
+            mergeProc(layout.procs[res.first->second], p);
+            alive[k] = false;
+            removed += p.codeEnd - p.codeStart;
+            changed = true;
+        }
+    }
+    return removed;
+}
+
+// ------------------ Wspólne końcówki (cross-jumping) ------------------
+
+long long Folder::mergeTails() {
+    // Grupujemy skoki bezwarunkowe / RTRN / HALT według miejsca, do którego prowadzą
+    std::map<std::string, std::vector<long long>> groups;
+    for (long long i = 0; i < (long long)code.size(); i++) {
+        const Line &in = code[i];
+        if (in.deleted) continue;
+        if (in.op == Op::JUMP)      groups["J" + std::to_string(resolve(in.target))].push_back(i);
+        else if (in.op == Op::RTRN) groups["R" + std::to_string(in.arg)].push_back(i);
+        else if (in.op == Op::HALT) groups["H"].push_back(i);
+    }
+
+    long long removed = 0;
+    for (auto &entry : groups) {
+        const std::vector<long long> &ends = entry.second;
+        for (size_t jj = 1; jj < ends.size(); jj++) {
+            long long j = ends[jj];
+            if (code[j].deleted) continue;
+
+            long long best = 0, bestEnd = -1;
+            for (size_t ii = 0; ii < jj; ii++) {
+                long long i = ends[ii];
+                if (code[i].deleted) continue;
+                long long m = 0;
+                while (true) {
+                    long long pi = i - m - 1, pj = j - m - 1;
+                    if (pi < 1 || pj <= i) break;
+                    if (code[pi].deleted || code[pj].deleted || !same(code[pi], code[pj])) break;
+                    m++;
+                }
+                if (m > best) {
+                    best = m;
+                    bestEnd = i;
+                }
+            }
+            if (best < 1) continue;
+
+            // [j-best, j] => JUMP do [bestEnd-best, bestEnd]
+            long long start = j - best;
+            long long keepStart = bestEnd - best;
+            Line jump;
+            jump.op = Op::JUMP;
+            jump.kind = OperandKind::JUMP;
+            jump.target = keepStart;
+            code[start] = jump;
+            for (long long p = start + 1; p <= j; p++) {
+                code[p].deleted = true;
+                redirect[p] = keepStart + (p - start);
+            }
+            removed += best;
+        }
+    }
+    return removed;
+}
+
+// Skok na "JUMP t" => od razu na t
+void Folder::threadJumps() {
+    for (auto &in : code) {
+        if (in.deleted) continue;
+        if (in.kind != OperandKind::JUMP && in.kind != OperandKind::CODE_ADDR) continue;
+        long long t = resolve(in.target);
+        for (size_t hops = 0; hops < code.size() && code[t].op == Op::JUMP; hops++) {
+            long long next = resolve(code[t].target);
+            if (next == t) break;
+            t = next;
+        }
+        in.target = t;
+    }
+}
+
+void Folder::encode(Code &instructions) {
+    std::vector<long long> newIndex(code.size(), -1);
+    long long n = 0;
+    for (size_t i = 0; i < code.size(); i++) {
+        if (!code[i].deleted) newIndex[i] = n++;
+    }
+
+    Code out;
+    out.reserve(n);
+    for (size_t i = 0; i < code.size(); i++) {
+        Line &in = code[i];
+        if (in.deleted) continue;
+        if (in.kind == OperandKind::JUMP)
+            in.arg = newIndex[resolve(in.target)] - newIndex[i];
+        else if (in.kind == OperandKind::CODE_ADDR)
+            in.arg = newIndex[resolve(in.target)];
+        out.push_back({in.op, in.arg});
+    }
+    instructions.swap(out);
+}
+
+} // namespace
+
+// ------------------ Przebieg ------------------
+
+long long postprocessCode(Code &instructions, const CodeLayout &layout,
+                          bool dropDeadStores, bool fold) {
+    if (!dropDeadStores && !fold) return 0;
+    Folder folder(instructions, layout);
+    long long removed = 0;
+    if (dropDeadStores) removed += folder.dropDeadStores();
+    if (fold) {
+        removed += folder.foldProcedures();
+        removed += folder.mergeTails();
+        folder.threadJumps();
+    }
+    folder.encode(instructions);
+    return removed;
+}
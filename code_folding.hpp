@@ -0,0 +1,39 @@
+#ifndef CODE_FOLDING_HPP
+#define CODE_FOLDING_HPP
+
+#include "instruction.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////
+// Przebiegi po generacji kodu: martwe zapisy, scalanie identycznego kodu
+//////////////////////////////////////
+
+// Kod i pamięć jednej procedury (pamięć przydzielana monotonicznie => przedział)
+struct ProcRange {
+    long long codeStart = 0, codeEnd = 0; // [start, end) w instructions
+    long long memLo = 0, memHi = 0;       // [lo, hi) komórki własne procedury
+    bool keepsState = false;              // lokalne niosą wartość do następnego wywołania => bez scalania
+};
+
+// Informacje z generatora, których nie da się odczytać z samego tekstu kodu
+struct CodeLayout {
+    std::set<long long> codeAddrSets;         ///< linie "SET k", gdzie k to adres kodu (powrotu)
+    std::map<long long, long long> memAddrSets; ///< linia "SET a" z adresem tablicy => pierwsza komórka tablicy
+    std::vector<ProcRange> procs;
+    std::set<long long> tempCells;            ///< komórki robocze (czytane tylko wprost, nigdy przez LOADI)
+};
+
+// Przebiegi po generacji; zwracają liczbę usuniętych instrukcji.
+// dropDeadStores: STORE do komórek roboczych, których nic nie czyta.
+// fold: procedury identyczne z dokładnością do własnej pamięci (wywołania
+// przekierowane na pierwszą z nich; bez procedur z keepsState, bo scalenie
+// złączyłoby dwa niezależne stany) i wspólne końcówki bloków kończących się
+// tym samym skokiem / RTRN / HALT.
+long long postprocessCode(Code &instructions, const CodeLayout &layout,
+                          bool dropDeadStores, bool fold);
+
+#endif // CODE_FOLDING_HPP
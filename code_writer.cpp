@@ -0,0 +1,67 @@
+#include "code_writer.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+CodeWriter::~CodeWriter() {
+    if (fd >= 0) ::close(fd);
+}
+
+bool CodeWriter::open(const std::string &path) {
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    failed = fd < 0;
+    used = 0;
+    return fd >= 0;
+}
+
+void CodeWriter::write(const Instr &in) {
+    if (kBufferSize - used < kMaxLine) flush();
+    char* p = buffer + used;
+
+    const char* name = opName(in.op);
+    size_t len = std::strlen(name);
+    std::memcpy(p, name, len);
+    p += len;
+
+    if (hasOperand(in.op)) {
+        *p++ = ' ';
+        // liczba od końca, jak std::to_string (także LLONG_MIN)
+        unsigned long long v = in.arg < 0 ? 0ULL - (unsigned long long)in.arg
+                                          : (unsigned long long)in.arg;
+        char digits[20];
+        int n = 0;
+        do {
+            digits[n++] = (char)('0' + v % 10);
+            v /= 10;
+        } while (v);
+        if (in.arg < 0) *p++ = '-';
+        while (n) *p++ = digits[--n];
+    }
+    *p++ = '\n';
+    used = (size_t)(p - buffer);
+}
+
+void CodeWriter::write(const Code &code) {
+    for (const Instr &in : code) write(in);
+}
+
+void CodeWriter::flush() {
+    size_t done = 0;
+    while (!failed && done < used) {
+        ssize_t n = ::write(fd, buffer + done, used - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) failed = true;
+        else done += (size_t)n;
+    }
+    used = 0;
+}
+
+bool CodeWriter::close() {
+    if (fd < 0) return false;
+    flush();
+    if (::close(fd) != 0) failed = true;
+    fd = -1;
+    return !failed;
+}
@@ -0,0 +1,41 @@
+#ifndef CODE_WRITER_HPP
+#define CODE_WRITER_HPP
+
+#include "instruction.hpp"
+
+#include <cstddef>
+#include <string>
+
+//////////////////////////////////////
+// Zapis kodu maszyny do pliku
+//////////////////////////////////////
+//
+// Instrukcje formatowane od razu do stałego bufora i wypisywane write()
+// na deskryptor, kiedy bufor się zapełni — bez napisu na linię i bez
+// kopii całego programu w pamięci.
+class CodeWriter {
+public:
+    CodeWriter() = default;
+    ~CodeWriter();
+
+    CodeWriter(const CodeWriter &) = delete;
+    CodeWriter &operator=(const CodeWriter &) = delete;
+
+    bool open(const std::string &path); ///< false => nie da się utworzyć pliku
+    void write(const Instr &in);
+    void write(const Code &code);
+    bool close();                       ///< false => błąd zapisu (np. brak miejsca)
+
+private:
+    static const size_t kBufferSize = 1 << 16;
+    static const size_t kMaxLine = 32;  ///< najdłuższa linia: "STOREI -9223372036854775808\n"
+
+    int fd = -1;
+    bool failed = false;
+    size_t used = 0;
+    char buffer[kBufferSize];
+
+    void flush();
+};
+
+#endif // CODE_WRITER_HPP
@@ -1,59 +1,117 @@
 #include "codegen_visitor.hpp"
-#include <sstream>
 #include <iostream>
 #include <cassert>
+#include <algorithm>
+#include <unordered_map>
 #include "memory_manager.hpp"
+#include "thread_pool.hpp"
+#include "ast_opt.hpp"
 
 // ------------------ Podstawy ------------------
 
-std::string CodeGenVisitor::getCode() {
-    std::ostringstream os;
-    for (auto &line : instructions) {
-        os << line << "\n";
-    }
-    return os.str();
+void CodeGenVisitor::emit(Op op, long long arg) {
+    long long pos = instructions.size();
+    if (pendingTargets.erase(pos)) forgetAcc(); // tu wpada skok z przodu
+    trackAcc(op, arg, pos);
+    instructions.push_back({op, arg});
+    lineCounter++;
 }
 
-void CodeGenVisitor::emit(const std::string &cmd) {
-    instructions.push_back(cmd);
-    lineCounter++;
+void CodeGenVisitor::emit(const Instr &in) {
+    emit(in.op, in.arg);
 }
 
 void CodeGenVisitor::insertFirstJump() {
     long long k = lineCounter;
-    instructions.insert(instructions.begin(), "JUMP " + std::to_string(k));
+    instructions.insert(instructions.begin(), Instr{Op::JUMP, k});
+    // pozycje przesunięte o 1; main zaczyna się od skoku
+    for (auto &pos : trapJumps) pos++;
+    pendingTargets.clear();
+    forgetAcc();
+}
+
+// ------------------ Śledzenie akumulatora ------------------
+
+void CodeGenVisitor::forgetAcc() {
+    acc = AccState();
+}
+
+void CodeGenVisitor::markLabel() {
+    // cel skoku wstecz: stan z innej ścieżki nieznany
+    forgetAcc();
+}
+
+void CodeGenVisitor::trackAcc(Op op, long long arg, long long pos) {
+    if (isJumpOp(op)) {
+        // skok w przód o znanej długości => cel trzeba unieważnić, gdy do niego dojdziemy
+        // (skok do uzupełnienia ma jeszcze 0)
+        if (arg > 0) pendingTargets.insert(pos + arg);
+        if (op == Op::JUMP) forgetAcc(); // następna instrukcja osiągalna tylko skokiem
+    } else if (op == Op::LOAD) {
+        if (!acc.cells.count(arg)) {
+            forgetAcc();
+            acc.cells.insert(arg);
+        }
+    } else if (op == Op::SET) {
+        forgetAcc();
+        acc.knownConst = true;
+        acc.value = arg;
+    } else if (op == Op::STORE) {
+        acc.cells.insert(arg);
+    } else if (op == Op::STOREI) {
+        // zapisuje p0 => kopie p0 nadal równe p0
+    } else if (op == Op::GET) {
+        if (arg == 0) forgetAcc();
+        else acc.cells.erase(arg);
+    } else if (op == Op::PUT) {
+        // bez zmian
+    } else {
+        // ADD/SUB/ADDI/SUBI/LOADI/HALF zmieniają p0; RTRN/HALT kończą blok
+        forgetAcc();
+    }
+}
+
+void CodeGenVisitor::emitLoad(long long addr) {
+    if (acc.cells.count(addr)) return; // p0 już ma tę wartość
+    emit(Op::LOAD, addr);
+}
+
+void CodeGenVisitor::emitSet(long long value) {
+    if (acc.knownConst && acc.value == value) return;
+    emit(Op::SET, value);
 }
 
 long long CodeGenVisitor::allocateTemp() {
-    return memmgr.allocate(1);
+    long long addr = memmgr.allocate(1);
+    layout.tempCells.insert(addr);
+    return addr;
 }
 void CodeGenVisitor::freeTemp(long long addr) {
 }
 
-SymbolInfo* CodeGenVisitor::getSymbol(const std::string &name) {
+SymbolInfo* CodeGenVisitor::getSymbol(IdentifierNode &idn) {
+    // rozwiązane w analizie semantycznej => wprost z magazynu
+    if (idn.sym >= 0) return &symTab.at(idn.sym);
+    return getSymbol(idn.name);
+}
+
+SymbolInfo* CodeGenVisitor::getSymbol(Name name) {
+    // iterator otwartej pętli FOR (w tablicy symboli jego zasięg już zamknięty)
+    auto it = openIters.find(name);
+    if (it != openIters.end()) return it->second;
 
     SymbolInfo* si = symTab.lookup(name, currentProcedure);
     if (!si) {
-        std::cerr << "CODEGEN ERROR: no symbol " << name << std::endl;
+        *symTab.diag << "CODEGEN ERROR: no symbol " << name << std::endl;
     }
     return si;
 }
 
 void CodeGenVisitor::fixupJump(size_t instrPos, long long offset) {
-    // Podmieniamy w instructions[instrPos] "???" na offset
-    std::string old = instructions[instrPos];
-    size_t sp = old.find(' ');
-    if (sp==std::string::npos) return;
-    std::string opcode = old.substr(0, sp);
-    std::ostringstream oss;
-    oss << opcode << " " << offset;
-    instructions[instrPos] = oss.str();
-}
-
-std::string CodeGenVisitor::makeLabel(const std::string &prefix) {
-    std::ostringstream oss;
-    oss << prefix << "_" << labelCounter++;
-    return oss.str();
+    // Wpisujemy w skok instructions[instrPos] jego długość
+    instructions[instrPos].arg = offset;
+    // skok na bieżący koniec => następna instrukcja jest celem
+    if ((long long)instrPos + offset == (long long)instructions.size()) forgetAcc();
 }
 
 // ------------------ Pomocnicze: tablice ------------------
@@ -65,304 +123,1264 @@ void CodeGenVisitor::genArrOffset(long long base, long long lb, bool paramFlag)
 
     // 1) Zachowujemy "index" w temp
     long long tmpIdx = allocateTemp();
-    emit("STORE " + std::to_string(tmpIdx));
-    emit("SET " + std::to_string(base));
-    emit("ADD " + std::to_string(tmpIdx));
+    emit(Op::STORE, tmpIdx);
+    layout.memAddrSets[lineCounter] = base + lb;
+    emit(Op::SET, base);
+    emit(Op::ADD, tmpIdx);
 
 
     // posprzątaj
     freeTemp(tmpIdx);
 }
 
+// ------------------ genArrAddress ------------------
+void CodeGenVisitor::genArrAddress(IdentifierNode &node, SymbolInfo* si) {
+    // Wynik: p0 = adres komórki node[index].
+    node.indexExpr->accept(*this); // index => p0
+    if (checkBounds) {
+        // iterator pętli, której zakres sprawdzono przed nią => bez kontroli
+        auto* iter = dynamic_cast<IdentifierNode*>(node.indexExpr);
+        auto it = iter ? checkedIters.find(iter->name) : checkedIters.end();
+        if (it == checkedIters.end() || !it->second.count(si)) genBoundCheck(si);
+    }
+    if (si->ifParam) {
+        // Tablica-parametr: komórka si->addr trzyma bazę (ustawioną raz przy
+        // wejściu do procedury), więc dodajemy ją wprost - bez LOAD/STORE do tempa.
+        emit(retAdd(si->addr, false));
+    } else {
+        genArrOffset(si->addr, si->lowerBound, si->ifParam);
+    }
+}
+
+
+// ------------------ Kontrola zakresu ------------------
+
+long long CodeGenVisitor::boundCells(SymbolInfo* si) const {
+    return si->ifParam ? si->addr + 1 : si->addr + si->lowerBound - 2;
+}
+
+void CodeGenVisitor::genBoundCheck(SymbolInfo* si) {
+    long long lo = boundCells(si);
+    emit(Op::STORE, boundIdx);
+    emit(Op::SUB, lo);
+    emit(Op::JNEG);
+    trapJumps.push_back(instructions.size() - 1);
+    emit(Op::LOAD, boundIdx);
+    emit(Op::SUB, lo + 1);
+    emit(Op::JPOS);
+    trapJumps.push_back(instructions.size() - 1);
+    emit(Op::LOAD, boundIdx);
+}
+
+// Tablice indeksowane samym iteratorem (w poddrzewie)
+static void collectIterIndexed(ASTNode* node, Name iter, std::set<Name> &out) {
+    if (!node) return;
+    if (auto* cmds = dynamic_cast<CommandsNode*>(node)) {
+        for (auto* c : cmds->cmdList) collectIterIndexed(c, iter, out);
+    } else if (auto* cmd = dynamic_cast<CommandNode*>(node)) {
+        for (auto* c : cmd->children) collectIterIndexed(c, iter, out);
+    } else if (auto* e = dynamic_cast<ExpressionNode*>(node)) {
+        collectIterIndexed(e->left, iter, out);
+        collectIterIndexed(e->right, iter, out);
+    } else if (auto* idn = dynamic_cast<IdentifierNode*>(node)) {
+        auto* idx = dynamic_cast<IdentifierNode*>(idn->indexExpr);
+        if (idx && !idx->indexExpr && idx->name == iter) out.insert(idn->name);
+    }
+}
+
+// Dostępy wykonywane w każdym obrocie: polecenia wprost na liście ciała
+// (bez IF/WHILE/REPEAT i pętli zagnieżdżonych, które mogą się nie wykonać)
+static void collectEveryIteration(ASTNode* body, Name iter, std::set<Name> &out) {
+    auto* cmds = dynamic_cast<CommandsNode*>(body);
+    if (!cmds) return;
+    for (auto* c : cmds->cmdList) {
+        auto* cmd = dynamic_cast<CommandNode*>(c);
+        if (!cmd) continue;
+        if (cmd->cmdKind == CommandKind::ASSIGN || cmd->cmdKind == CommandKind::READ
+            || cmd->cmdKind == CommandKind::WRITE)
+            collectIterIndexed(cmd, iter, out);
+    }
+}
+
+void CodeGenVisitor::genHoistedChecks(CommandNode &node, std::vector<size_t> &failJumps) {
+    if (!checkBounds || !hoistChecks) return;
+    auto* iter = dynamic_cast<IdentifierNode*>(node.children[0]);
+    if (!iter) return;
+    std::set<Name> names;
+    collectEveryIteration(node.children[3], iter->name, names);
+
+    // iterator przebiega [lo, hi] (o ile pętla w ogóle się wykona)
+    bool up = node.cmdKind == CommandKind::FOR_UP;
+    ASTNode* lo = node.children[up ? 1 : 2];
+    ASTNode* hi = node.children[up ? 2 : 1];
+    auto* loVal = dynamic_cast<ValueNode*>(lo);
+    auto* hiVal = dynamic_cast<ValueNode*>(hi);
+
+    for (auto &name : names) {
+        SymbolInfo* si = getSymbol(name);
+        if (!si || si->kind != SymbolKind::ARR) continue;
+        checkedIters[iter->name].insert(si);
+
+        // stałe granice: pusta pętla albo zakres w deklaracji => nic do sprawdzania
+        if (loVal && hiVal && (loVal->val > hiVal->val
+            || (!si->ifParam && loVal->val >= si->lowerBound && hiVal->val <= si->upperBound)))
+            continue;
+
+        long long cells = boundCells(si);
+        hi->accept(*this);
+        emit(Op::STORE, boundTmp);
+        lo->accept(*this);
+        emit(Op::STORE, boundIdx);
+        emit(Op::SUB, boundTmp);
+        emit(Op::JPOS); // lo > hi => pętla pusta
+        size_t skipPos = instructions.size() - 1;
+        emit(Op::LOAD, boundIdx);
+        emit(Op::SUB, cells);
+        emit(Op::JNEG);
+        failJumps.push_back(instructions.size() - 1);
+        emit(Op::LOAD, boundTmp);
+        emit(Op::SUB, cells + 1);
+        emit(Op::JPOS);
+        failJumps.push_back(instructions.size() - 1);
+        fixupJump(skipPos, instructions.size() - skipPos);
+    }
+}
+
+// ------------------ Wyrażenia: kolejność obliczania (Sethi–Ullman) ------------------
+
+bool CodeGenVisitor::directAddress(ASTNode* node, long long &addr) {
+    // Operand dostępny wprost w pamięci: zmienna albo t[stała] tablicy nie-parametru
+    auto* idn = dynamic_cast<IdentifierNode*>(node);
+    if (!idn) return false;
+    SymbolInfo* si = getSymbol(*idn);
+    if (!si) return false;
+    if (!idn->indexExpr) {
+        addr = si->addr;
+        return true;
+    }
+    auto* idx = dynamic_cast<ValueNode*>(idn->indexExpr);
+    if (!idx || si->ifParam) return false;
+    // poza zakresem => zwykła ścieżka z kontrolą w czasie wykonania
+    if (checkBounds && (idx->val < si->lowerBound || idx->val > si->upperBound)) return false;
+    addr = si->addr + idx->val;
+    return true;
+}
+
+static bool isArrayElement(ASTNode* node) {
+    auto* idn = dynamic_cast<IdentifierNode*>(node);
+    return idn && idn->indexExpr;
+}
+
+void CodeGenVisitor::orderOperands(const std::string &op, ASTNode* &left, ASTNode* &right) {
+    // right = operand brany z pamięci (wprost albo po odłożeniu do komórki)
+    if (op != "+" && op != "*") return;
+    if (op == "*") {
+        // genMultiply obraca pętlę po bitach memY => stała (zwykle mała) jako memY
+        if (dynamic_cast<ValueNode*>(right)) return;
+        if (dynamic_cast<ValueNode*>(left)) {
+            std::swap(left, right);
+            return;
+        }
+    }
+    long long addr;
+    bool leftDirect = directAddress(left, addr);
+    bool rightDirect = directAddress(right, addr);
+    if (rightDirect) return;
+    if (leftDirect) {
+        std::swap(left, right);
+        return;
+    }
+    if (op == "+" && isArrayElement(right)) return;
+    if (op == "+" && isArrayElement(left)) {
+        std::swap(left, right);
+        return;
+    }
+    // cięższe poddrzewo liczymy pierwsze i odkładamy; lżejsze ma wtedy do dyspozycji więcej komórek
+    if (spillNeed(left) > spillNeed(right)) std::swap(left, right);
+}
+
+int CodeGenVisitor::spillNeed(ASTNode* node) {
+    if (auto* idn = dynamic_cast<IdentifierNode*>(node)) {
+        long long addr;
+        if (!idn->indexExpr || directAddress(node, addr)) return 0;
+        return spillNeed(idn->indexExpr);
+    }
+    auto* expr = dynamic_cast<ExpressionNode*>(node);
+    if (!expr) return 0;
+
+    bool relational = !(expr->op == "+" || expr->op == "-" || expr->op == "*"
+                        || expr->op == "/" || expr->op == "%");
+    std::string op = relational ? "-" : expr->op;
+    ASTNode* left = expr->left;
+    ASTNode* right = expr->right;
+    orderOperands(op, left, right);
+
+    long long addr;
+    if (op != "/" && op != "%" && directAddress(right, addr)) return spillNeed(left);
+    if ((op == "+" || op == "-") && isArrayElement(right)) {
+        auto* idn = static_cast<IdentifierNode*>(right);
+        return std::max(spillNeed(idn->indexExpr), 1 + spillNeed(left));
+    }
+    return std::max(spillNeed(right), 1 + spillNeed(left));
+}
+
+long long CodeGenVisitor::acquireSpill() {
+    if (spillDepth == (long long)spillSlots.size()) spillSlots.push_back(allocateTemp());
+    return spillSlots[spillDepth++];
+}
+
+void CodeGenVisitor::releaseSpill() {
+    spillDepth--;
+}
+
+bool CodeGenVisitor::genConstMultiply(ASTNode* left, long long c) {
+    if (c == 0) {
+        emitSet(0);
+        return true;
+    }
+    unsigned long long m = c < 0 ? 0ULL - (unsigned long long)c : (unsigned long long)c;
+    if (m & (m - 1)) return false;
+
+    // |c| = 2^k => k podwojeń (ADD 0), ujemne przez 0 - x
+    left->accept(*this);
+    for (; m > 1; m >>= 1) emit(Op::ADD, 0);
+    if (c < 0) {
+        long long slot = acquireSpill();
+        emit(Op::STORE, slot);
+        emit(Op::SET, 0);
+        emit(Op::SUB, slot);
+        releaseSpill();
+    }
+    return true;
+}
+
+void CodeGenVisitor::genBinary(const std::string &op, ASTNode* left, ASTNode* right) {
+    orderOperands(op, left, right);
+
+    long long addr;
+    long long slot = -1;
+    if (op == "*") {
+        // stała (po orderOperands zawsze z prawej): 0, ±1, ±2, ... bez pętli
+        auto* val = dynamic_cast<ValueNode*>(right);
+        if (val && genConstMultiply(left, val->val)) return;
+        long long leftAddr;
+        if (directAddress(left, leftAddr) && directAddress(right, addr) && leftAddr == addr) {
+            left->accept(*this);
+            genSquare();
+            return;
+        }
+    }
+    if (op != "/" && op != "%" && directAddress(right, addr)) {
+        // prawy operand wprost z pamięci - bez komórki roboczej
+        left->accept(*this);
+    } else if ((op == "+" || op == "-") && isArrayElement(right)) {
+        // element tablicy: tylko adres, potem ADDI/SUBI
+        auto* idn = static_cast<IdentifierNode*>(right);
+        genArrAddress(*idn, getSymbol(*idn));
+        slot = acquireSpill();
+        emit(Op::STORE, slot);
+        left->accept(*this);
+        emit(op == "+" ? retAdd(slot, true) : retSub(slot, true));
+        releaseSpill();
+        return;
+    } else {
+        // prawy pierwszy (odłożony), lewy w p0; głębsze odłożenia w kolejnych komórkach
+        // (genDivision nadpisuje swój operand, więc zmienna idzie przez komórkę)
+        right->accept(*this);
+        slot = acquireSpill();
+        emit(Op::STORE, slot);
+        left->accept(*this);
+        addr = slot;
+    }
+
+    if (op == "+")      emit(Op::ADD, addr);
+    else if (op == "-") emit(Op::SUB, addr);
+    else if (op == "*") genMultiply(addr);
+    else if (op == "/") genDivision(addr, false);
+    else if (op == "%") genDivision(addr, true);
+
+    if (slot >= 0) releaseSpill();
+}
+
+// ------------------ Skoki warunkowe ------------------
+
+void CodeGenVisitor::genCondJump(ASTNode* cond, bool jumpIfTrue, std::vector<size_t> &fixups) {
+    // p0 = left - right, potem skoki wg znaku; wynik 0/1 nie powstaje
+    auto* expr = dynamic_cast<ExpressionNode*>(cond);
+    static const char* relOps[] = {"==", "!=", "<", ">", "<=", ">="};
+    bool relational = expr && std::find(std::begin(relOps), std::end(relOps), expr->op) != std::end(relOps);
+
+    std::string op = "!=";
+    if (!relational) {
+        cond->accept(*this); // warunek liczbowy: prawda <=> p0 != 0
+    } else {
+        op = expr->op;
+        genBinary("-", expr->left, expr->right);
+    }
+
+    // Znaki różnicy, przy których warunek jest prawdziwy
+    bool neg = (op == "!=" || op == "<" || op == "<=");
+    bool zero = (op == "==" || op == "<=" || op == ">=");
+    bool pos = (op == "!=" || op == ">" || op == ">=");
+    if (!jumpIfTrue) {
+        neg = !neg;
+        zero = !zero;
+        pos = !pos;
+    }
+    if (neg)  { emit(Op::JNEG);  fixups.push_back(instructions.size() - 1); }
+    if (zero) { emit(Op::JZERO); fixups.push_back(instructions.size() - 1); }
+    if (pos)  { emit(Op::JPOS);  fixups.push_back(instructions.size() - 1); }
+}
+
+// ------------------ Prefiks policzony w czasie kompilacji ------------------
+
+void CodeGenVisitor::genPrefix(size_t totalCommands) {
+    // 1) Wypisane wartości: SET v; PUT 0 (SET pomijamy, gdy p0 już ma v)
+    bool haveLast = false;
+    long long last = 0;
+    for (long long v : prefixEval->outputs) {
+        if (!haveLast || v != last) emit(Op::SET, v);
+        emit(Op::PUT, 0);
+        haveLast = true;
+        last = v;
+    }
+
+    // 2) Cały main policzony => pamięci nie trzeba odtwarzać
+    if (prefixEval->consumed >= totalCommands) return;
+
+    // 3) Stan pamięci czytany przez resztę programu: SET v; STORE addr.
+    //    Sortujemy po wartości, żeby równe wartości dzieliły jeden SET.
+    std::vector<std::pair<long long, long long>> cells; // (wartość, adres)
+    for (auto &entry : prefixEval->scalars) {
+        SymbolInfo* si = entry.first;
+        if (si && si->addr >= 1 && prefixEval->isLive(si))
+            cells.push_back({entry.second, si->addr});
+    }
+    for (auto &entry : prefixEval->arrays) {
+        SymbolInfo* si = entry.first;
+        if (!si || !prefixEval->isLive(si)) continue;
+        for (auto &el : entry.second)
+            cells.push_back({el.second, si->addr + el.first});
+    }
+    std::sort(cells.begin(), cells.end());
+    for (auto &c : cells) {
+        if (!haveLast || c.first != last) emit(Op::SET, c.first);
+        emit(Op::STORE, c.second);
+        haveLast = true;
+        last = c.first;
+    }
+}
+
+// ------------------ Pętle liczone wzorem zamkniętym ------------------
+
+void CodeGenVisitor::genClosedFormFor(CommandNode &node, const ClosedFormLoop &cf) {
+    // [0]=iter, [1]=fromVal, [2]=toVal, [3]=body (same akumulatory)
+    bool up = (node.cmdKind == CommandKind::FOR_UP);
+    long long tmpFrom = allocateTemp();
+    long long tmpTo = allocateTemp();
+    long long tmpN = allocateTemp();
+
+    node.children[1]->accept(*this);
+    emit(Op::STORE, tmpFrom);
+    node.children[2]->accept(*this);
+    emit(Op::STORE, tmpTo);
+
+    // n-1 = to-from (w dół: from-to); ujemne => zero obrotów, pomijamy wszystko
+    emit(Op::LOAD, up ? tmpTo : tmpFrom);
+    emit(Op::SUB, up ? tmpFrom : tmpTo);
+    emit(Op::JNEG);
+    size_t guardPos = instructions.size() - 1;
+    emit(Op::STORE, tmpN);
+    emit(Op::SET, 1);
+    emit(Op::ADD, tmpN);
+    emit(Op::STORE, tmpN);
+
+    // iterator przebiega [lo, hi] niezależnie od kierunku
+    long long lo = up ? tmpFrom : tmpTo;
+    long long hi = up ? tmpTo : tmpFrom;
+    for (auto &rec : cf.recs) {
+        genAccumulate(rec, tmpN, lo, hi);
+    }
+
+    fixupJump(guardPos, instructions.size() - guardPos);
+    freeTemp(tmpFrom);
+    freeTemp(tmpTo);
+    freeTemp(tmpN);
+}
+
+void CodeGenVisitor::genClosedFormWhile(CommandNode &node, const ClosedFormLoop &cf) {
+    // WHILE v < b: n = b - v;  v <= b: n = b - v + 1;  (> / >= symetrycznie, krok -1)
+    SymbolInfo* ctr = getSymbol(cf.counter);
+    long long tmpN = allocateTemp();
+
+    cf.bound->accept(*this);
+    if (cf.counterStep > 0) {
+        emit(Op::SUB, ctr->addr);
+    } else {
+        long long tmpB = allocateTemp();
+        emit(Op::STORE, tmpB);
+        emit(Op::LOAD, ctr->addr);
+        emit(Op::SUB, tmpB);
+        freeTemp(tmpB);
+    }
+
+    size_t guardPos;
+    if (cf.inclusive) {
+        emit(Op::JNEG);
+        guardPos = instructions.size() - 1;
+        emit(Op::STORE, tmpN);
+        emit(Op::SET, 1);
+        emit(Op::ADD, tmpN);
+        emit(Op::STORE, tmpN);
+    } else {
+        emit(Op::JPOS, 2);
+        emit(Op::JUMP);
+        guardPos = instructions.size() - 1;
+        emit(Op::STORE, tmpN);
+    }
+
+    for (auto &rec : cf.recs) {
+        genAccumulate(rec, tmpN, 0, 0);
+    }
+
+    // licznik kończy na v +/- n
+    emit(Op::LOAD, ctr->addr);
+    emit(cf.counterStep > 0 ? Op::ADD : Op::SUB, tmpN);
+    emit(Op::STORE, ctr->addr);
+
+    fixupJump(guardPos, instructions.size() - guardPos);
+    freeTemp(tmpN);
+}
+
+void CodeGenVisitor::genAccumulate(const AccumulatorRec &rec, long long memN,
+                                   long long memLo, long long memHi) {
+    // p0 = łączny przyrost po n obrotach, potem acc (+|-)= p0
+    SymbolInfo* si = getSymbol(rec.acc);
+    auto* lit = dynamic_cast<ValueNode*>(rec.factor);
+
+    switch (rec.step) {
+    case AccStep::INVARIANT:
+        if (lit && lit->val == 0) return;
+        if (lit && lit->val == 1) {
+            emit(Op::LOAD, memN);
+        } else {
+            rec.factor->accept(*this);
+            genMultiply(memN);
+        }
+        break;
+
+    case AccStep::ITERATOR:
+    case AccStep::SCALED_ITERATOR: {
+        // lo + ... + hi = (lo + hi) * n / 2  (iloczyn zawsze parzysty)
+        emit(Op::LOAD, memLo);
+        emit(Op::ADD, memHi);
+        genMultiply(memN);
+        emit(Op::HALF);
+        if (rec.step == AccStep::SCALED_ITERATOR) {
+            long long tmpS = allocateTemp();
+            emit(Op::STORE, tmpS);
+            rec.factor->accept(*this);
+            genMultiply(tmpS);
+            freeTemp(tmpS);
+        }
+        break;
+    }
+
+    case AccStep::SQUARED_ITERATOR: {
+        // lo^2 + ... + hi^2 = F(hi) - F(lo-1)
+        long long tmpHi = allocateTemp();
+        long long tmpLo = allocateTemp();
+        genSquareSum(memHi);
+        emit(Op::STORE, tmpHi);
+        emit(Op::SET, -1);
+        emit(Op::ADD, memLo);
+        emit(Op::STORE, tmpLo);
+        genSquareSum(tmpLo);
+        emit(Op::STORE, tmpLo);
+        emit(Op::LOAD, tmpHi);
+        emit(Op::SUB, tmpLo);
+        freeTemp(tmpHi);
+        freeTemp(tmpLo);
+        break;
+    }
+    }
+
+    if (!rec.subtract) {
+        emit(Op::ADD, si->addr);
+    } else {
+        long long tmpD = allocateTemp();
+        emit(Op::STORE, tmpD);
+        emit(Op::LOAD, si->addr);
+        emit(Op::SUB, tmpD);
+        freeTemp(tmpD);
+    }
+    emit(Op::STORE, si->addr);
+}
+
+void CodeGenVisitor::genSquareSum(long long memX) {
+    long long tmpX1 = allocateTemp();  // x + 1
+    long long tmpX2 = allocateTemp();  // 2x + 1
+    long long tmpSix = allocateTemp();
+    emit(Op::SET, 1);
+    emit(Op::ADD, memX);
+    emit(Op::STORE, tmpX1);
+    emit(Op::ADD, memX);
+    emit(Op::STORE, tmpX2);
+    emit(Op::SET, 6);
+    emit(Op::STORE, tmpSix);
+    emit(Op::LOAD, memX);
+    genMultiply(tmpX1);
+    genMultiply(tmpX2);
+    genDivision(tmpSix, false); // dzielenie dokładne
+    freeTemp(tmpX1);
+    freeTemp(tmpX2);
+    freeTemp(tmpSix);
+}
 
 // ------------------ Logarytmiczne mnożenie i dzielenie ------------------
 
 void CodeGenVisitor::genMultiply(long long memY)
 {
-    // 1) p0=x, memY => y
-    // 2) obsługa znaku
-    // 3) while (y>0)
-    long long tmpX = allocateTemp();
-    long long tmpY = allocateTemp();
-    long long tmpRes = allocateTemp();
-    long long tmpSign = allocateTemp();
-
-    // store x => tmpX
-    emit("STORE " + std::to_string(tmpX));
-    emit("SET 0");
-    emit("STORE " + std::to_string(tmpSign));
-    emit("SET 0");
-    emit("STORE " + std::to_string(tmpRes));
-    emit("LOAD " + std::to_string(memY));
-    emit("STORE " + std::to_string(tmpY));
-    //Sprawdzanie znaku Y
-    emit("JZERO 53"); // na sam koniec !!!!!!!!!!!!!!!!
-    emit("JNEG 4");
-    emit("SET 1");
-    emit("ADD " + std::to_string(tmpSign));
-    emit("JUMP 6");
-    emit("SET 0");
-    emit("SUB " + std::to_string(tmpY));
-    emit("STORE " + std::to_string(tmpY));
-    emit("SET -1");
-    emit("ADD " + std::to_string(tmpSign));
-    emit("STORE " + std::to_string(tmpSign));
-    // Sprawdzanie znaku X
-    emit("LOAD " + std::to_string(tmpX));
-    emit("JZERO 41"); // na sam koniec !!!!!!!!!!!!!!!!
-    emit("JNEG 4");
-    emit("SET 1");
-    emit("ADD " + std::to_string(tmpSign));
-    emit("JUMP 6");
-    emit("SET 0");
-    emit("SUB " + std::to_string(tmpX));
-    emit("STORE " + std::to_string(tmpX));
-    emit("SET -1");
-    emit("ADD " + std::to_string(tmpSign));
-    emit("STORE " + std::to_string(tmpSign));
-    // pierwszy krok
-    emit("LOAD " + std::to_string(tmpX));
-    emit("STORE " + std::to_string(tmpRes));
-    emit("SET -1");
-    emit("ADD " + std::to_string(tmpY));
-    emit("STORE " + std::to_string(tmpY));
-    // petla
-    emit("JZERO 19");
-    emit("HALF");
-    emit("ADD 0");
-    emit("SUB " + std::to_string(tmpY));
-    emit("JZERO 8");
-    emit("LOAD " + std::to_string(tmpX));
-    emit("ADD " + std::to_string(tmpRes));
-    emit("STORE " + std::to_string(tmpRes));
-    emit("SET -1");
-    emit("ADD " + std::to_string(tmpY));
-    emit("STORE " + std::to_string(tmpY));
-    emit("JUMP -11");
-    emit("LOAD " + std::to_string(tmpX));
-    emit("ADD " + std::to_string(tmpX));
-    emit("STORE " + std::to_string(tmpX));
-    emit("LOAD " + std::to_string(tmpY));
-    emit("HALF");
-    emit("STORE " + std::to_string(tmpY));
-    emit("JUMP -18");
+    // 1) p0=x, memY => y; x albo y równe 0 => wynik 0 od razu, y = 1 => x, y = 2 => x + x
+    // 2) znak wyniku (parzystość liczby ujemnych) i moduły
+    // 3) pętla po bitach mniejszego modułu
+    // komórki wspólne dla wszystkich mnożeń => identyczne sekwencje (code_folding)
+    long long tmpX = mulScratch;
+    long long tmpY = mulScratch + 1;
+    long long tmpRes = mulScratch + 2;
+    long long tmpSign = mulScratch + 3;
+    long long tmpSwap = mulScratch + 4;
+    std::vector<size_t> zeroJumps;
+
+    emit(Op::STORE, tmpX);
+    emit(Op::SET, 0);
+    emit(Op::STORE, tmpSign);
+    emit(Op::STORE, tmpRes);
+    // Moduł Y
+    emit(Op::LOAD, memY);
+    emit(Op::JZERO);
+    zeroJumps.push_back(instructions.size() - 1);
+    emit(Op::JPOS, 6);
+    emit(Op::SET, 1);
+    emit(Op::STORE, tmpSign);
+    emit(Op::SET, 0);
+    emit(Op::SUB, memY);
+    emit(Op::JUMP, 8);
+    // y > 0: y = 1 i y = 2 bez pętli
+    emit(Op::SET, 1);
+    emit(Op::SUB, memY);
+    emit(Op::JZERO);
+    size_t onePos = instructions.size() - 1;
+    emit(Op::SET, 2);
+    emit(Op::SUB, memY);
+    emit(Op::JZERO);
+    size_t twoPos = instructions.size() - 1;
+    emit(Op::LOAD, memY);
+    emit(Op::STORE, tmpY);
+    // Moduł X
+    emit(Op::LOAD, tmpX);
+    emit(Op::JZERO);
+    zeroJumps.push_back(instructions.size() - 1);
+    emit(Op::JPOS, 7);
+    emit(Op::SET, 1);
+    emit(Op::SUB, tmpSign);
+    emit(Op::STORE, tmpSign);
+    emit(Op::SET, 0);
+    emit(Op::SUB, tmpX);
+    emit(Op::STORE, tmpX);
+    // |x| < |y| => zamiana: pętla obraca się tyle razy, ile bitów ma mniejszy
+    emit(Op::SUB, tmpY);
+    emit(Op::JPOS, 8);
+    emit(Op::JZERO, 7);
+    emit(Op::LOAD, tmpX);
+    emit(Op::STORE, tmpSwap);
+    emit(Op::LOAD, tmpY);
+    emit(Op::STORE, tmpX);
+    emit(Op::LOAD, tmpSwap);
+    emit(Op::STORE, tmpY);
+
+    genMultiplyLoop(true);
+    emit(Op::JUMP);
+    size_t endPos = instructions.size() - 1;
+    fixupJump(onePos, instructions.size() - onePos);
+    emit(Op::LOAD, tmpX);
+    emit(Op::JUMP);
+    size_t oneEndPos = instructions.size() - 1;
+    fixupJump(twoPos, instructions.size() - twoPos);
+    emit(Op::LOAD, tmpX);
+    emit(Op::ADD, 0);
+    fixupJump(endPos, instructions.size() - endPos);
+    fixupJump(oneEndPos, instructions.size() - oneEndPos);
+    for (size_t pos : zeroJumps) fixupJump(pos, instructions.size() - pos); // p0 = 0
+}
+
+void CodeGenVisitor::genSquare()
+{
+    // p0=x => p0=x*x; wynik nieujemny, oba czynniki równe => bez zamiany i znaku
+    long long tmpX = mulScratch;
+    long long tmpY = mulScratch + 1;
+    long long tmpRes = mulScratch + 2;
+
+    emit(Op::STORE, tmpX);
+    emit(Op::JPOS, 4);
+    emit(Op::SET, 0);
+    emit(Op::SUB, tmpX);
+    emit(Op::STORE, tmpX);
+    emit(Op::STORE, tmpY);
+    emit(Op::SET, 0);
+    emit(Op::STORE, tmpRes);
+    genMultiplyLoop(false);
+}
+
+void CodeGenVisitor::genMultiplyLoop(bool withSign)
+{
+    // tmpX, tmpY >= 0, tmpRes = 0 => p0 = tmpX * tmpY (z tmpSign: ujemny przy nieparzystym)
+    long long tmpX = mulScratch;
+    long long tmpY = mulScratch + 1;
+    long long tmpRes = mulScratch + 2;
+    long long tmpSign = mulScratch + 3;
+
+    emit(Op::LOAD, tmpY);
+    markLabel();
+    // bit najmłodszy: y - 2*(y/2) != 0 => res += x
+    emit(Op::HALF);
+    emit(Op::ADD, 0);
+    emit(Op::SUB, tmpY);
+    emit(Op::JZERO, 4);
+    emit(Op::LOAD, tmpX);
+    emit(Op::ADD, tmpRes);
+    emit(Op::STORE, tmpRes);
+    // x *= 2, y /= 2; y == 0 => koniec (nieparzyste y zaokrągla się w dół)
+    emit(Op::LOAD, tmpX);
+    emit(Op::ADD, 0);
+    emit(Op::STORE, tmpX);
+    emit(Op::LOAD, tmpY);
+    emit(Op::HALF);
+    emit(Op::JZERO, 3);
+    emit(Op::STORE, tmpY);
+    emit(Op::JUMP, -14);
     // koniec pętli
-    emit("LOAD " + std::to_string(tmpSign));
-    emit("JZERO 3");
-    emit("LOAD " + std::to_string(tmpRes));
-    emit("JUMP 3");
-    emit("SET 0");
-    emit("SUB " + std::to_string(tmpRes));
+    if (withSign) {
+        emit(Op::LOAD, tmpSign);
+        emit(Op::JZERO, 4);
+        emit(Op::SET, 0);
+        emit(Op::SUB, tmpRes);
+        emit(Op::JUMP, 2);
+    }
+    emit(Op::LOAD, tmpRes);
 }
 
 void CodeGenVisitor::genDivision(long long memY, bool doMod)
 {
-    long long tmpX = allocateTemp();
-    long long tmpY = allocateTemp();
-    long long res = allocateTemp();
-    long long mod = allocateTemp();
+    // komórki wspólne dla wszystkich dzieleń (jak w genMultiply)
+    long long tmpX = divScratch;
+    long long tmpY = divScratch + 1;
+    long long res = divScratch + 2;
+    long long mod = divScratch + 3;
 
-    long long sign = allocateTemp();
-    long long signY = allocateTemp();
+    long long sign = divScratch + 4;
+    long long signY = divScratch + 5;
 
-    long long midRes = allocateTemp();
-    long long divShift = allocateTemp();
-    long long divCounter = allocateTemp();
-    long long sumCount = allocateTemp();
+    long long midRes = divScratch + 6;
+    long long divShift = divScratch + 7;
+    long long divCounter = divScratch + 8;
+    long long sumCount = divScratch + 9;
 
     //Ładowanie zmiennych i sprawdzanie 
-    emit("JZERO 116"); // ??????????????????????????????????????????
-    emit("STORE " + std::to_string(tmpX));
-    emit("LOAD " + std::to_string(memY));
-    emit("STORE " + std::to_string(tmpY));
-    emit("JZERO 112"); // ?????????????????????????????????????????????
-    emit("JPOS 3");
-    emit("SET -1");
-    emit("JUMP 2");
-    emit("SET 1");
-    emit("STORE " + std::to_string(signY));
-    emit("SET 0");
-    emit("STORE " + std::to_string(sign));
-
-    emit("LOAD " + std::to_string(tmpX));
-    emit("JPOS 7");
-    emit("SET 0");
-    emit("SUB " + std::to_string(tmpX));
-    emit("STORE " + std::to_string(tmpX));
-    emit("SET -1");
-    emit("ADD " + std::to_string(sign));
-    emit("JUMP 3");
-    emit("SET 1");
-    emit("ADD " + std::to_string(sign));
-    emit("STORE " + std::to_string(sign));
-
-    emit("LOAD " + std::to_string(tmpY));
-    emit("JPOS 7");
-    emit("SET 0");
-    emit("SUB " + std::to_string(tmpY));
-    emit("STORE " + std::to_string(tmpY));
-    emit("SET -1");
-    emit("ADD " + std::to_string(sign));
-    emit("JUMP 3");
-    emit("SET 1");
-    emit("ADD " + std::to_string(sign));
-    emit("STORE " + std::to_string(sign));
+    emit(Op::JZERO, 116); // ??????????????????????????????????????????
+    emit(Op::STORE, tmpX);
+    emit(Op::LOAD, memY);
+    emit(Op::STORE, tmpY);
+    emit(Op::JZERO, 112); // ?????????????????????????????????????????????
+    emit(Op::JPOS, 3);
+    emit(Op::SET, -1);
+    emit(Op::JUMP, 2);
+    emit(Op::SET, 1);
+    emit(Op::STORE, signY);
+    emit(Op::SET, 0);
+    emit(Op::STORE, sign);
+
+    emit(Op::LOAD, tmpX);
+    emit(Op::JPOS, 7);
+    emit(Op::SET, 0);
+    emit(Op::SUB, tmpX);
+    emit(Op::STORE, tmpX);
+    emit(Op::SET, -1);
+    emit(Op::ADD, sign);
+    emit(Op::JUMP, 3);
+    emit(Op::SET, 1);
+    emit(Op::ADD, sign);
+    emit(Op::STORE, sign);
+
+    emit(Op::LOAD, tmpY);
+    emit(Op::JPOS, 7);
+    emit(Op::SET, 0);
+    emit(Op::SUB, tmpY);
+    emit(Op::STORE, tmpY);
+    emit(Op::SET, -1);
+    emit(Op::ADD, sign);
+    emit(Op::JUMP, 3);
+    emit(Op::SET, 1);
+    emit(Op::ADD, sign);
+    emit(Op::STORE, sign);
 
     // Przygotowanie zmiennych
 
-    emit("SET 0");
-    emit("STORE " + std::to_string(res));
-    emit("STORE " + std::to_string(sumCount));
-    emit("STORE " + std::to_string(mod));
+    emit(Op::SET, 0);
+    emit(Op::STORE, res);
+    emit(Op::STORE, sumCount);
+    emit(Op::STORE, mod);
 
-    emit("LOAD " + std::to_string(tmpY));
-    emit("STORE " + std::to_string(divShift));
-    emit("STORE " + std::to_string(midRes));
+    emit(Op::LOAD, tmpY);
+    emit(Op::STORE, divShift);
+    emit(Op::STORE, midRes);
 
-    emit("SET 1");
-    emit("STORE " + std::to_string(divCounter));
+    emit(Op::SET, 1);
+    emit(Op::STORE, divCounter);
 
-    emit("LOAD " + std::to_string(midRes));
-    emit("SUB " + std::to_string(tmpX));
+    emit(Op::LOAD, midRes);
+    emit(Op::SUB, tmpX);
 
 
     // Pętla 1.
 
-    emit("JZERO 60"); // ?????
-    emit("JPOS 17"); // ??????
+    emit(Op::JZERO, 60); // ?????
+    emit(Op::JPOS, 17); // ??????
 
-    emit("LOAD " + std::to_string(midRes));
-    emit("STORE " + std::to_string(res));
-    emit("LOAD " + std::to_string(divCounter));
-    emit("ADD " + std::to_string(sumCount));
-    emit("STORE " + std::to_string(sumCount));
+    emit(Op::LOAD, midRes);
+    emit(Op::STORE, res);
+    emit(Op::LOAD, divCounter);
+    emit(Op::ADD, sumCount);
+    emit(Op::STORE, sumCount);
 
-    emit("LOAD " + std::to_string(divCounter));
-    emit("ADD " + std::to_string(divCounter));
-    emit("STORE " + std::to_string(divCounter));
+    emit(Op::LOAD, divCounter);
+    emit(Op::ADD, divCounter);
+    emit(Op::STORE, divCounter);
 
-    emit("LOAD " + std::to_string(divShift));
-    emit("ADD " + std::to_string(divShift));
-    emit("STORE " + std::to_string(divShift));
+    emit(Op::LOAD, divShift);
+    emit(Op::ADD, divShift);
+    emit(Op::STORE, divShift);
 
-    emit("LOAD " + std::to_string(res));
-    emit("ADD " + std::to_string(divShift));
-    emit("STORE " + std::to_string(midRes));
+    emit(Op::LOAD, res);
+    emit(Op::ADD, divShift);
+    emit(Op::STORE, midRes);
 
-    emit("SUB " + std::to_string(tmpX));
+    emit(Op::SUB, tmpX);
 
-    emit("JUMP -17");
+    emit(Op::JUMP, -17);
 
     // Pętla 2.
 
-    emit("LOAD " + std::to_string(divCounter));
-    emit("JZERO 20"); // ??????
-    emit("LOAD " + std::to_string(divShift));
-    emit("ADD " + std::to_string(res));
-    emit("STORE " + std::to_string(midRes));
+    emit(Op::LOAD, divCounter);
+    emit(Op::JZERO, 20); // ??????
+    emit(Op::LOAD, divShift);
+    emit(Op::ADD, res);
+    emit(Op::STORE, midRes);
 
-    emit("SUB " + std::to_string(tmpX));
+    emit(Op::SUB, tmpX);
 
-    emit("JZERO 36"); // ??????
-    emit("JPOS 7"); // ??????
+    emit(Op::JZERO, 36); // ??????
+    emit(Op::JPOS, 7); // ??????
 
-    emit("LOAD " + std::to_string(res));
-    emit("ADD " + std::to_string(divShift));
-    emit("STORE " + std::to_string(res));
+    emit(Op::LOAD, res);
+    emit(Op::ADD, divShift);
+    emit(Op::STORE, res);
 
-    emit("LOAD " + std::to_string(sumCount));
-    emit("ADD " + std::to_string(divCounter));
-    emit("STORE " + std::to_string(sumCount));
+    emit(Op::LOAD, sumCount);
+    emit(Op::ADD, divCounter);
+    emit(Op::STORE, sumCount);
 
-    emit("LOAD " + std::to_string(divShift));
-    emit("HALF");
-    emit("STORE " + std::to_string(divShift));
+    emit(Op::LOAD, divShift);
+    emit(Op::HALF);
+    emit(Op::STORE, divShift);
 
-    emit("LOAD " + std::to_string(divCounter));
-    emit("HALF");
-    emit("STORE " + std::to_string(divCounter));
+    emit(Op::LOAD, divCounter);
+    emit(Op::HALF);
+    emit(Op::STORE, divCounter);
 
-    emit("JUMP -20");
+    emit(Op::JUMP, -20);
 
     // Koniec
 
-    emit("LOAD " + std::to_string(sign));
-    emit("JZERO 5");
-    emit("LOAD " + std::to_string(tmpX));
-    emit("SUB " + std::to_string(res));
-    emit("STORE " + std::to_string(mod));
-    emit("JUMP 10");
-
-    emit("LOAD " + std::to_string(tmpX));
-    emit("SUB " + std::to_string(res));
-    emit("STORE " + std::to_string(mod));
-    emit("LOAD " + std::to_string(tmpY));
-    emit("SUB " + std::to_string(mod));
-    emit("STORE " + std::to_string(mod));
-    emit("SET -1");
-    emit("SUB " + std::to_string(sumCount));
-    emit("STORE " + std::to_string(sumCount));
-
-    emit("LOAD " + std::to_string(signY));
-    emit("JPOS 4");
-    emit("SET 0");
-    emit("SUB " + std::to_string(mod));
-    emit("STORE " + std::to_string(mod));
-
-    emit("JUMP 10");
-    emit("LOAD " + std::to_string(divCounter));
-    emit("ADD " + std::to_string(sumCount));
-    emit("STORE " + std::to_string(sumCount));
-    emit("LOAD " + std::to_string(sign));
-    emit("JZERO 2");
-    emit("JUMP 4");
-    emit("SET 0");
-    emit("SUB " + std::to_string(sumCount));
-    emit("STORE " + std::to_string(sumCount));
+    emit(Op::LOAD, sign);
+    emit(Op::JZERO, 5);
+    emit(Op::LOAD, tmpX);
+    emit(Op::SUB, res);
+    emit(Op::STORE, mod);
+    emit(Op::JUMP, 10);
+
+    emit(Op::LOAD, tmpX);
+    emit(Op::SUB, res);
+    emit(Op::STORE, mod);
+    emit(Op::LOAD, tmpY);
+    emit(Op::SUB, mod);
+    emit(Op::STORE, mod);
+    emit(Op::SET, -1);
+    emit(Op::SUB, sumCount);
+    emit(Op::STORE, sumCount);
+
+    emit(Op::LOAD, signY);
+    emit(Op::JPOS, 4);
+    emit(Op::SET, 0);
+    emit(Op::SUB, mod);
+    emit(Op::STORE, mod);
+
+    emit(Op::JUMP, 10);
+    emit(Op::LOAD, divCounter);
+    emit(Op::ADD, sumCount);
+    emit(Op::STORE, sumCount);
+    emit(Op::LOAD, sign);
+    emit(Op::JZERO, 2);
+    emit(Op::JUMP, 4);
+    emit(Op::SET, 0);
+    emit(Op::SUB, sumCount);
+    emit(Op::STORE, sumCount);
 
     if (doMod) {
-        emit("LOAD " + std::to_string(mod));
-        emit("STORE " + std::to_string(memY));
+        emit(Op::LOAD, mod);
+        emit(Op::STORE, memY);
     } else {
-        emit("LOAD " + std::to_string(sumCount));
-        emit("STORE " + std::to_string(memY));
+        emit(Op::LOAD, sumCount);
+        emit(Op::STORE, memY);
     }
 
-    emit("JUMP 2"); // ?????
-    emit("SET 0");
+    emit(Op::JUMP, 2); // ?????
+    emit(Op::SET, 0);
 }
 
 
-// ------------------ Wizytory AST ------------------
+// ------------------ Profil wykonania ------------------
 
-void CodeGenVisitor::visit(ProgramAllNode &node) {
-    memmgr.memSetNextAddress(1);
-    lineCounter = 1;
-    if (node.procedures) node.procedures->accept(*this);
-    insertFirstJump();
-    if (node.mainPart) node.mainPart->accept(*this);
-    emit("HALT");
+void CodeGenVisitor::genCounter(ASTNode* block) {
+    if (!profileGen || !profile || counterBase < 0) return;
+    int id = profile->idOf(block);
+    if (id < 0) return;
+    emitSet(1);
+    emit(Op::ADD, counterBase + id);
+    emit(Op::STORE, counterBase + id);
 }
 
-void CodeGenVisitor::visit(ProceduresNode &node) {
-    for (auto* prc : node.procedureDecls) {
-        prc->accept(*this);
+// Szacunek statyczny: gałąź z pętlą gorąca, sama komunikacja (READ/WRITE) zimna
+static int staticHeat(ASTNode* node) {
+    bool loop = false, io = false, other = false;
+    std::vector<ASTNode*> work{node};
+    while (!work.empty()) {
+        ASTNode* n = work.back();
+        work.pop_back();
+        if (auto* cmds = dynamic_cast<CommandsNode*>(n)) {
+            work.insert(work.end(), cmds->cmdList.begin(), cmds->cmdList.end());
+        } else if (auto* cmd = dynamic_cast<CommandNode*>(n)) {
+            switch (cmd->cmdKind) {
+            case CommandKind::WHILE:
+            case CommandKind::REPEAT_UNTIL:
+            case CommandKind::FOR_UP:
+            case CommandKind::FOR_DOWN:
+                loop = true;
+                break;
+            case CommandKind::READ:
+            case CommandKind::WRITE:
+                io = true;
+                break;
+            case CommandKind::IF_THEN:
+            case CommandKind::IF_THEN_ELSE:
+                work.insert(work.end(), cmd->children.begin() + 1, cmd->children.end());
+                break;
+            default:
+                other = true;
+            }
+        }
     }
+    if (loop) return 2;
+    return (io && !other) ? 0 : 1;
 }
 
-void CodeGenVisitor::visit(ProcHeadNode &node) {
-    // nic
+bool CodeGenVisitor::elseIsLikely(CommandNode &node) {
+    if (profile && !profileGen) {
+        long long thenCount = profile->countOf(node.children[1]);
+        long long elseCount = profile->countOf(node.children[2]);
+        if (thenCount >= 0 && elseCount >= 0) return elseCount > thenCount;
+    }
+    return staticHeat(node.children[2]) > staticHeat(node.children[1]);
 }
 
-void CodeGenVisitor::visit(ProcedureDeclNode &node) {
-    // Zapamiętaj poprzednią nazwę
-    std::string oldProc = currentProcedure;
-    // Ustaw aktualną
+// ------------------ Pętla FOR ------------------
+
+void CodeGenVisitor::genCountedLoop(CommandNode &node) {
+    bool up = node.cmdKind == CommandKind::FOR_UP;
+
+    // 1. Iterator (lokalny dla pętli, symbol założony w analizie semantycznej)
+    auto* idn = dynamic_cast<IdentifierNode*>(node.children[0]);
+    SymbolInfo* si = getSymbol(*idn);
+    if (si->addr < 1) si->addr = memmgr.allocate(1);
+
+    // 2. iter = from, limit = to (granice liczone raz)
+    long long limitAddr = memmgr.allocate(1);
+    node.children[2]->accept(*this);
+    emit(Op::STORE, limitAddr);
+    node.children[1]->accept(*this);
+    emit(Op::STORE, si->addr);
+
+    // 3. Strażnik: pusta pętla => za nią
+    emit(Op::SUB, limitAddr);
+    emit(up ? Op::JPOS : Op::JNEG);
+    size_t exitPos = instructions.size() - 1;
+
+    // 4. Ciało; test na dole, skok wstecz to przypadek częsty (rotacja jak w WHILE)
+    long long bodyLab = instructions.size();
+    markLabel();
+    openIters[idn->name] = si; // argumenty wywołań w ciele są po nazwie
+    node.children[3]->accept(*this);
+    openIters.erase(idn->name);
+
+    // 5. iter ±= 1 (stała 1 w komórce: ADD/SUB zamiast SET ±1), dalej póki iter nie minął limitu
+    emitLoad(si->addr);
+    emit(up ? Op::ADD : Op::SUB, oneCell);
+    emit(Op::STORE, si->addr);
+    emit(Op::SUB, limitAddr);
+    emit(up ? Op::JNEG : Op::JPOS, bodyLab - (long long)instructions.size());
+    emit(Op::JZERO, bodyLab - (long long)instructions.size());
+
+    fixupJump(exitPos, instructions.size() - exitPos);
+
+    checkedIters.erase(idn->name);
+}
+
+static bool hasForLoop(ASTNode* node) {
+    if (auto* procs = dynamic_cast<ProceduresNode*>(node)) {
+        for (auto* p : procs->procedureDecls) {
+            if (hasForLoop(p)) return true;
+        }
+        return false;
+    }
+    if (auto* pd = dynamic_cast<ProcedureDeclNode*>(node)) return hasForLoop(pd->commands);
+    if (auto* mn = dynamic_cast<MainNode*>(node)) return hasForLoop(mn->commands);
+    if (auto* cmds = dynamic_cast<CommandsNode*>(node)) {
+        for (auto* c : cmds->cmdList) {
+            if (hasForLoop(c)) return true;
+        }
+        return false;
+    }
+    auto* cmd = dynamic_cast<CommandNode*>(node);
+    if (!cmd) return false;
+    if (cmd->cmdKind == CommandKind::FOR_UP || cmd->cmdKind == CommandKind::FOR_DOWN) return true;
+    for (auto* c : cmd->children) {
+        if (hasForLoop(c)) return true;
+    }
+    return false;
+}
+
+// ------------------ Procedury: bufory i łączenie ------------------
+
+CodeGenVisitor::CodeGenVisitor(const CodeGenVisitor &parent, int frameNo)
+    : symTab(parent.symTab), lineCounter(0), profile(parent.profile),
+      profileGen(parent.profileGen), checkBounds(parent.checkBounds), frame(frameNo)
+{
+    memmgr.memSetNextAddress((long long)frameNo << kFrameShift);
+    // komórki wspólne (robocze, liczniki, stała 1) mają już adresy rzeczywiste
+    spillSlots = parent.spillSlots;
+    mulScratch = parent.mulScratch;
+    divScratch = parent.divScratch;
+    counterBase = parent.counterBase;
+    oneCell = parent.oneCell;
+    boundIdx = parent.boundIdx;
+    boundTmp = parent.boundTmp;
+}
+
+long long CodeGenVisitor::frameOf(long long addr) {
+    // ramka k leży wokół k << kFrameShift (baza tablicy bywa przed ramką)
+    return (addr + (1LL << (kFrameShift - 1))) >> kFrameShift;
+}
+
+long long CodeGenVisitor::relocate(long long addr) const {
+    long long k = frameOf(addr);
+    if (k <= 0 || k > (long long)frameBases.size()) return addr;
+    return frameBases[k - 1] + (addr - (k << kFrameShift));
+}
+
+void CodeGenVisitor::linkProcedures(std::vector<std::unique_ptr<CodeGenVisitor>> &units,
+                                    const std::vector<ProcedureDeclNode*> &decls) {
+    // 1. Ramki i początki kodu po kolei (jak przy generacji jednym przebiegiem)
+    std::vector<long long> codeBases;
+    long long codeNext = lineCounter;
+    for (size_t k = 0; k < units.size(); k++) {
+        long long base = memmgr.getNextAddress();
+        long long size = units[k]->memmgr.getNextAddress() - ((long long)(k + 1) << kFrameShift);
+        frameBases.push_back(base);
+        memmgr.memSetNextAddress(base + size);
+        codeBases.push_back(codeNext);
+        codeNext += units[k]->instructions.size();
+    }
+    std::unordered_map<Name, long long> frameDeltas;
+    for (size_t k = 0; k < units.size(); k++) {
+        SymbolInfo* si = getSymbol(decls[k]->procName);
+        si->addr = codeBases[k];
+        si->returnAddr = relocate(si->returnAddr);
+        for (auto &addr : si->paramAddrs) addr = relocate(addr);
+        frameDeltas[decls[k]->procName] = frameBases[k] - ((long long)(k + 1) << kFrameShift);
+    }
+    // Zmienne procedur też: main (prefiks policzony w czasie kompilacji) pisze do ich komórek
+    for (auto &sym : symTab.symbols) {
+        if (sym.kind == SymbolKind::PROC || sym.addr == -1) continue;
+        auto it = frameDeltas.find(sym.ownerProcName);
+        if (it != frameDeltas.end()) sym.addr += it->second;
+    }
+
+    // 2. Kod z przeliczonymi operandami
+    for (size_t k = 0; k < units.size(); k++) {
+        CodeGenVisitor &unit = *units[k];
+        long long codeBase = codeBases[k];
+        long long frameDelta = frameBases[k] - ((long long)(k + 1) << kFrameShift);
+        std::map<size_t, SymbolInfo*> calls(unit.callFixups.begin(), unit.callFixups.end());
+
+        instructions.reserve(instructions.size() + unit.instructions.size());
+        for (size_t i = 0; i < unit.instructions.size(); i++) {
+            // skoki do pułapki (jeszcze 0) uzupełniane na końcu programu
+            Instr out = unit.instructions[i];
+            auto call = calls.find(i);
+            if (call != calls.end()) {
+                out.arg = call->second->addr - (codeBase + (long long)i);
+            } else if (out.op == Op::SET) {
+                auto mem = unit.layout.memAddrSets.find(i);
+                if (mem != unit.layout.memAddrSets.end()) {
+                    // baza tablicy (adres - lowerBound) może leżeć daleko od ramki
+                    long long cellDelta = relocate(mem->second) - mem->second;
+                    out.arg += cellDelta;
+                    layout.memAddrSets[codeBase + i] = mem->second + cellDelta;
+                } else if (unit.layout.codeAddrSets.count(i)) {
+                    out.arg += codeBase;
+                    layout.codeAddrSets.insert(codeBase + i);
+                }
+            } else if (isMemoryOp(out.op)) {
+                out.arg = relocate(out.arg);
+            }
+            instructions.push_back(out);
+            lineCounter++;
+        }
+
+        ProcRange range;
+        range.codeStart = codeBase;
+        range.codeEnd = codeBase + unit.instructions.size();
+        range.memLo = frameBases[k];
+        range.memHi = unit.memmgr.getNextAddress() + frameDelta;
+        range.keepsState = keepsStateBetweenCalls(decls[k]);
+        layout.procs.push_back(range);
+
+        for (long long cell : unit.layout.tempCells) layout.tempCells.insert(relocate(cell));
+        for (size_t pos : unit.trapJumps) trapJumps.push_back(codeBase - 1 + pos);
+        for (auto &init : unit.boundInits) boundInits.push_back({init.first + frameDelta, init.second});
+    }
+}
+
+// ------------------ Procedury: pamięć podręczna ------------------
+
+namespace {
+// Bajty kolejnych wartości (klucz pamięci podręcznej procedur)
+struct Fingerprint {
+    std::string bytes;
+
+    void mix(uint64_t v) {
+        for (int i = 0; i < 8; i++) bytes += (char)((v >> (8 * i)) & 0xff);
+    }
+    void mix(const std::string &s) {
+        mix(s.size());
+        bytes += s;
+    }
+    void mix(Name n) { mix(n.str()); }
+};
+}
+
+// Struktura poddrzewa bez numerów linii (przesunięcie procedury w pliku nie
+// zmienia jej kodu). Identyfikator: nazwa i numer symbolu wśród symboli
+// procedury (indeks w tablicy zależy od reszty programu). Wołane procedury => callees.
+static void fingerprintAST(Fingerprint &fp, const ASTNode* node,
+                           const std::unordered_map<int, int> &ordinal, std::vector<Name> &callees) {
+    if (!node) {
+        fp.mix(0);
+        return;
+    }
+    if (auto* decls = dynamic_cast<const DeclarationsNode*>(node)) {
+        fp.mix(1);
+        fp.mix(decls->declList.size());
+        for (auto* d : decls->declList) fingerprintAST(fp, d, ordinal, callees);
+    } else if (auto* dv = dynamic_cast<const DeclarationVarNode*>(node)) {
+        fp.mix(2);
+        fp.mix(dv->varName);
+    } else if (auto* da = dynamic_cast<const DeclarationArrNode*>(node)) {
+        fp.mix(3);
+        fp.mix(da->arrName);
+        fp.mix(da->lowerBound);
+        fp.mix(da->upperBound);
+    } else if (auto* cmds = dynamic_cast<const CommandsNode*>(node)) {
+        fp.mix(4);
+        fp.mix(cmds->cmdList.size());
+        for (auto* c : cmds->cmdList) fingerprintAST(fp, c, ordinal, callees);
+    } else if (auto* cmd = dynamic_cast<const CommandNode*>(node)) {
+        fp.mix(5);
+        fp.mix((uint64_t)cmd->cmdKind);
+        fp.mix(cmd->children.size());
+        for (auto* c : cmd->children) fingerprintAST(fp, c, ordinal, callees);
+    } else if (auto* ad = dynamic_cast<const ArgsDeclNode*>(node)) {
+        fp.mix(6);
+        fp.mix(ad->argNames.size());
+        for (size_t i = 0; i < ad->argNames.size(); i++) {
+            fp.mix(ad->argNames[i]);
+            fp.mix(ad->isArray[i]);
+        }
+    } else if (auto* an = dynamic_cast<const ArgsNode*>(node)) {
+        fp.mix(7);
+        fp.mix(an->varNames.size());
+        for (Name n : an->varNames) fp.mix(n);
+    } else if (auto* pc = dynamic_cast<const ProcCallNode*>(node)) {
+        fp.mix(8);
+        fp.mix(pc->procName);
+        callees.push_back(pc->procName);
+        fingerprintAST(fp, pc->args, ordinal, callees);
+    } else if (auto* expr = dynamic_cast<const ExpressionNode*>(node)) {
+        fp.mix(9);
+        fp.mix((uint64_t)expr->exprKind);
+        fp.mix(expr->op);
+        fingerprintAST(fp, expr->left, ordinal, callees);
+        fingerprintAST(fp, expr->right, ordinal, callees);
+    } else if (auto* val = dynamic_cast<const ValueNode*>(node)) {
+        fp.mix(10);
+        fp.mix(val->val);
+    } else if (auto* idn = dynamic_cast<const IdentifierNode*>(node)) {
+        fp.mix(11);
+        fp.mix(idn->name);
+        auto it = ordinal.find(idn->sym);
+        fp.mix(it != ordinal.end() ? it->second : -1);
+        fingerprintAST(fp, idn->indexExpr, ordinal, callees);
+    } else {
+        fp.mix(12); // węzeł spoza procedur - nie powinien tu wystąpić
+    }
+}
+
+std::string CodeGenVisitor::procFingerprint(ProcedureDeclNode &node, const std::vector<int> &owned) {
+    // adres w ramce bez numeru ramki (ten zależy od pozycji procedury)
+    auto rel = [](long long addr) { return addr - (frameOf(addr) << kFrameShift); };
+    Fingerprint fp;
+
+    // Ustawienia i komórki wspólne
+    fp.mix(checkBounds);
+    fp.mix(profileGen);
+    fp.mix(spillSlots.size());
+    for (long long cell : spillSlots) fp.mix(cell);
+    for (long long cell : {mulScratch, divScratch, counterBase, oneCell, boundIdx, boundTmp}) fp.mix(cell);
+
+    // Ramka procedury i jej symbole
+    SymbolInfo* self = getSymbol(node.procName);
+    fp.mix(rel(memmgr.getNextAddress()));
+    fp.mix(rel(self->returnAddr));
+    for (long long addr : self->paramAddrs) fp.mix(rel(addr));
+    std::unordered_map<int, int> ordinal;
+    for (int idx : owned) {
+        const SymbolInfo &sym = symTab.at(idx);
+        ordinal[idx] = (int)ordinal.size();
+        fp.mix(sym.name);
+        fp.mix((uint64_t)sym.kind);
+        fp.mix(sym.ifParam);
+        fp.mix(sym.isForIterator);
+        fp.mix(sym.initialized);
+        fp.mix(sym.addr == -1 ? -1 : rel(sym.addr));
+        if (sym.kind == SymbolKind::ARR) {
+            fp.mix(sym.lowerBound);
+            fp.mix(sym.upperBound);
+            fp.mix(sym.lowerBoundOffset);
+        }
+    }
+
+    // Drzewo procedury
+    std::vector<Name> callees;
+    fingerprintAST(fp, node.argsDecl, ordinal, callees);
+    fingerprintAST(fp, node.localDecls, ordinal, callees);
+    fingerprintAST(fp, node.commands, ordinal, callees);
+
+    // Sygnatury wołanych: układ ich ramek (treść nie wpływa na kod wołającego)
+    for (Name callee : callees) {
+        SymbolInfo* si = getSymbol(callee);
+        fp.mix(callee);
+        fp.mix(rel(si->returnAddr));
+        for (long long addr : si->paramAddrs) fp.mix(rel(addr));
+        for (SymbolKind kind : si->paramKinds) fp.mix((uint64_t)kind);
+    }
+    return fp.bytes;
+}
+
+void CodeGenVisitor::saveProcedure(CachedProcedure &out, const std::vector<int> &owned,
+                                   const std::unordered_map<Name, long long> &procFrames) const {
+    out.instructions = instructions;
+    out.ownFrame = frame;
+    out.frameEnd = memmgr.getNextAddress();
+    for (auto &call : callFixups) {
+        out.calls.push_back({call.first, call.second->name});
+        out.frames[procFrames.at(call.second->name)] = call.second->name;
+    }
+    out.layout.memAddrSets = layout.memAddrSets;
+    out.layout.codeAddrSets = layout.codeAddrSets;
+    out.layout.tempCells = layout.tempCells;
+    out.trapJumps = trapJumps;
+    out.boundInits = boundInits;
+    for (int idx : owned) out.symbolAddrs.push_back(symTab.at(idx).addr);
+}
+
+void CodeGenVisitor::restoreProcedure(const CachedProcedure &in, const std::vector<int> &owned,
+                                      const std::unordered_map<Name, long long> &procFrames) {
+    // Ramki z chwili generacji => ramki w tym programie (własna i wołanych).
+    // Zapis mógł powstać dla innej procedury o tej samej treści (np. klonu).
+    auto move = [&](long long addr) {
+        long long k = frameOf(addr);
+        if (k == 0) return addr;
+        long long to = frame;
+        if (k != in.ownFrame) {
+            auto f = in.frames.find(k);
+            if (f == in.frames.end()) return addr;
+            to = procFrames.at(f->second);
+        }
+        return addr + ((to - k) << kFrameShift);
+    };
+    // Baza tablicy (adres - lowerBound) może leżeć daleko od ramki, nawet
+    // w sąsiedniej => przez pierwszą komórkę, jak SET-y adresów tablic
+    auto moveSymbol = [&](const SymbolInfo &sym, long long addr) {
+        if (sym.kind != SymbolKind::ARR || sym.ifParam || addr == -1) return move(addr);
+        return move(addr + sym.lowerBound) - sym.lowerBound;
+    };
+
+    // Zapis obejmuje też to, co dodało beginProcedure (np. granice tablic) => zastępujemy
+    instructions.clear();
+    lineCounter = 0;
+    layout = CodeLayout();
+    callFixups.clear();
+    boundInits.clear();
+    instructions.reserve(in.instructions.size());
+    for (size_t i = 0; i < in.instructions.size(); i++) {
+        Instr out = in.instructions[i];
+        auto mem = in.layout.memAddrSets.find(i);
+        if (out.op == Op::SET && mem != in.layout.memAddrSets.end()) {
+            long long cellDelta = move(mem->second) - mem->second;
+            out.arg += cellDelta;
+            layout.memAddrSets[i] = mem->second + cellDelta;
+        } else if (isMemoryOp(out.op)) {
+            out.arg = move(out.arg);
+        }
+        instructions.push_back(out);
+        lineCounter++;
+    }
+    layout.codeAddrSets = in.layout.codeAddrSets;
+    for (long long cell : in.layout.tempCells) layout.tempCells.insert(move(cell));
+    for (auto &call : in.calls) callFixups.push_back({call.first, getSymbol(call.second)});
+    trapJumps = in.trapJumps;
+    for (auto &init : in.boundInits) boundInits.push_back({move(init.first), init.second});
+    memmgr.memSetNextAddress(move(in.frameEnd));
+    for (size_t i = 0; i < owned.size(); i++) {
+        SymbolInfo &sym = symTab.at(owned[i]);
+        sym.addr = moveSymbol(sym, in.symbolAddrs[i]);
+    }
+}
+
+void CodeGenVisitor::beginProcedure(ProcedureDeclNode &node) {
     currentProcedure = node.procName;
-    
     SymbolInfo* si = getSymbol(node.procName);
     si->returnAddr = memmgr.allocate(1);
-    si->addr = lineCounter;
 
     if (node.argsDecl) node.argsDecl->accept(*this);
     if (node.localDecls) node.localDecls->accept(*this);
@@ -372,24 +1390,157 @@ void CodeGenVisitor::visit(ProcedureDeclNode &node) {
         SymbolInfo* si3 = getSymbol(si2->argNames[i]);
         si->paramAddrs.push_back(si3->addr);
     }
+}
+
+void CodeGenVisitor::genProcedureBody(ProcedureDeclNode &node) {
+    currentProcedure = node.procName;
+    SymbolInfo* si = getSymbol(node.procName);
+    markLabel();
+    genCounter(&node);
     if (node.commands)   node.commands->accept(*this);
 
-    emit("RTRN " + std::to_string(si->returnAddr));
+    emit(Op::RTRN, si->returnAddr);
+}
+
+// ------------------ Wizytory AST ------------------
+
+void CodeGenVisitor::visit(ProgramAllNode &node) {
+    memmgr.memSetNextAddress(1);
+    lineCounter = 1;
+    // Robocze komórki mnożenia/dzielenia: przed procedurami, poza ich pamięcią
+    mulScratch = memmgr.allocate(5);
+    divScratch = memmgr.allocate(10);
+    // Kilka komórek na odłożone operandy wyrażeń (głębsze dochodzą w miarę potrzeby)
+    for (int i = 0; i < 4; i++) spillSlots.push_back(allocateTemp());
+    bool counting = profileGen && profile && profile->size() > 0;
+    if (counting) counterBase = memmgr.allocate(profile->size());
+    if (hasForLoop(node.procedures) || hasForLoop(node.mainPart)) oneCell = memmgr.allocate(1);
+    if (checkBounds) {
+        boundIdx = memmgr.allocate(1);
+        boundTmp = memmgr.allocate(1);
+    }
+    if (node.procedures) node.procedures->accept(*this);
+    insertFirstJump();
+    if (oneCell >= 0) {
+        // stała 1 dla pętli FOR (procedury wołane dopiero z main)
+        emitSet(1);
+        emit(Op::STORE, oneCell);
+    }
+    if (counting) {
+        for (int i = 0; i < profile->size(); i++) {
+            emitSet(0);
+            emit(Op::STORE, counterBase + i);
+        }
+    }
+    if (node.mainPart) node.mainPart->accept(*this);
+    if (counting) {
+        // liczniki na końcu wyjścia, w kolejności numerów bloków
+        for (int i = 0; i < profile->size(); i++) emit(Op::PUT, counterBase + i);
+    }
+    emit(Op::HALT);
+    if (!trapJumps.empty()) {
+        // indeks spoza zakresu: wypisz go i zatrzymaj program
+        for (size_t pos : trapJumps) fixupJump(pos, instructions.size() - pos);
+        emit(Op::LOAD, boundIdx);
+        emit(Op::PUT, 0);
+        emit(Op::HALT);
+    }
+}
+
+void CodeGenVisitor::visit(ProceduresNode &node) {
+    std::vector<ProcedureDeclNode*> decls;
+    for (auto* prc : node.procedureDecls) {
+        if (auto* pd = dynamic_cast<ProcedureDeclNode*>(prc)) decls.push_back(pd);
+    }
 
-    // paramAddrs
+    // 1. Ramki po kolei: wywołania z innych procedur potrzebują adresów parametrów
+    std::vector<std::unique_ptr<CodeGenVisitor>> units;
+    for (size_t k = 0; k < decls.size(); k++) {
+        units.emplace_back(new CodeGenVisitor(*this, (int)k + 1));
+        units[k]->beginProcedure(*decls[k]);
+    }
 
-    // Przywróć poprzednią procedurę
+    // Odciski procedur dla pamięci podręcznej (liczniki profilu zależą od
+    // numeracji bloków całego programu => z profilem bez pamięci podręcznej)
+    bool caching = procCache && !profile;
+    std::vector<std::vector<int>> owned(decls.size());
+    std::vector<std::string> prints(decls.size());
+    std::unordered_map<Name, long long> procFrames;
+    if (caching) {
+        for (size_t k = 0; k < decls.size(); k++) procFrames[decls[k]->procName] = (long long)k + 1;
+        for (size_t i = 0; i < symTab.symbols.size(); i++) {
+            const SymbolInfo &sym = symTab.at((int)i);
+            auto it = procFrames.find(sym.ownerProcName);
+            if (sym.kind != SymbolKind::PROC && it != procFrames.end()) owned[it->second - 1].push_back((int)i);
+        }
+        for (size_t k = 0; k < decls.size(); k++) prints[k] = units[k]->procFingerprint(*decls[k], owned[k]);
+    }
+
+    // 2. Ciała niezależnie, na wątkach (niezmienione procedury z pamięci podręcznej)
+    parallelFor(units.size(), jobs, [&](size_t k) {
+        if (caching) {
+            CachedProcedure cached;
+            if (procCache->get(prints[k], cached)) {
+                units[k]->restoreProcedure(cached, owned[k], procFrames);
+                return;
+            }
+        }
+        units[k]->genProcedureBody(*decls[k]);
+        if (caching) {
+            CachedProcedure entry;
+            units[k]->saveProcedure(entry, owned[k], procFrames);
+            procCache->put(prints[k], std::move(entry));
+        }
+    });
+
+    // 3. Jeden za drugim, adresy rzeczywiste
+    linkProcedures(units, decls);
+}
+
+void CodeGenVisitor::visit(ProcHeadNode &node) {
+    // nic
+}
+
+void CodeGenVisitor::visit(ProcedureDeclNode &node) {
+    // Procedura w tym samym buforze (bez łączenia)
+    Name oldProc = currentProcedure;
+    SymbolInfo* si = getSymbol(node.procName);
+    ProcRange range;
+    range.memLo = memmgr.getNextAddress();
+    range.codeStart = lineCounter;
+    si->addr = lineCounter;
+    beginProcedure(node);
+    genProcedureBody(node);
+    range.codeEnd = lineCounter;
+    range.memHi = memmgr.getNextAddress();
+    layout.procs.push_back(range);
     currentProcedure = oldProc;
 }
 
 
 void CodeGenVisitor::visit(MainNode &node) {
     // zapamiętaj
-    std::string oldProc = currentProcedure;
+    Name oldProc = currentProcedure;
     currentProcedure = ""; // main
 
     if (node.declarations) node.declarations->accept(*this);
-    if (node.commands)     node.commands->accept(*this);
+
+    // granice wszystkich tablic lokalnych (pamięć statyczna => raz na początku)
+    for (auto &init : boundInits) {
+        emitSet(init.second);
+        emit(Op::STORE, init.first);
+    }
+
+    auto* cmds = dynamic_cast<CommandsNode*>(node.commands);
+    if (prefixEval && prefixEval->consumed > 0 && cmds) {
+        // początkowe komendy zastępujemy ich wynikiem, resztę generujemy normalnie
+        genPrefix(cmds->cmdList.size());
+        for (size_t i = prefixEval->consumed; i < cmds->cmdList.size(); i++) {
+            cmds->cmdList[i]->accept(*this);
+        }
+    } else if (node.commands) {
+        node.commands->accept(*this);
+    }
 
     // przywróć
     currentProcedure = oldProc;
@@ -414,6 +1565,12 @@ void CodeGenVisitor::visit(DeclarationArrNode &node) {
     // a faktyczny "size" będzie w run-time. 
     // Ale dla zwykłej tablicy:
         long long size = (node.upperBound - node.lowerBound + 1);
+        if (checkBounds) {
+            // [lo, hi] tuż przed danymi
+            long long cells = memmgr.allocate(2);
+            boundInits.push_back({cells, node.lowerBound});
+            boundInits.push_back({cells + 1, node.upperBound});
+        }
         si->addr = memmgr.allocate(size);
         si->addr -= node.lowerBound; // przesunięcie
         // debug:
@@ -421,6 +1578,7 @@ void CodeGenVisitor::visit(DeclarationArrNode &node) {
 }
 
 void CodeGenVisitor::visit(CommandsNode &node) {
+    genCounter(&node);
     for (auto* c: node.cmdList) {
         c->accept(*this);
     }
@@ -435,273 +1593,116 @@ void CodeGenVisitor::visit(CommandNode &node) {
 
     case CommandKind::ASSIGN: {
         // [0]=IdentifierNode, [1]=expression
-        node.children[1]->accept(*this); // oblicz expr => p0
         auto* idn = dynamic_cast<IdentifierNode*>(node.children[0]);
-        SymbolInfo* si = getSymbol(idn->name);
-
-
+        SymbolInfo* si = getSymbol(*idn);
 
         if (!idn->indexExpr) {
             // zwykła zmienna
+            node.children[1]->accept(*this); // oblicz expr => p0
             emit(retStore(si->addr, si->ifParam));
         } else {
-            // tablica: arr[i] := p0
-            long long temp = allocateTemp();
-            emit("STORE " + std::to_string(temp));  // p0 => temp
-            idn->indexExpr->accept(*this);  // oblicz index => p0
-            if (si->ifParam) {
-                long long temp2 = allocateTemp();
-                emit("STORE " + std::to_string(temp2));  // p0 => temp2
-                emit("LOAD " + std::to_string(si->addr));
-                emit("ADD " + std::to_string(temp2));
-                emit("STORE " + std::to_string(temp2));
-                emit("LOAD " + std::to_string(temp));
-                emit("STOREI " + std::to_string(temp2));
-                freeTemp(temp2);
-            }
-            else {
-                genArrOffset(si->addr, si->lowerBound, si->ifParam);
-                long long temp2 = allocateTemp();
-                emit("STORE " + std::to_string(temp2));  // p0 => temp2
-                emit("LOAD " + std::to_string(temp));  // temp => p0
-                emit("STOREI " + std::to_string(temp2));  // p0 => memory[temp2] 
-            }
-            freeTemp(temp);
+            // tablica: arr[i] := expr
+            // najpierw adres (do tempa), potem wartość prosto w p0 => STOREI
+            long long tempAddr = allocateTemp();
+            genArrAddress(*idn, si);
+            emit(Op::STORE, tempAddr);
+            node.children[1]->accept(*this); // oblicz expr => p0
+            emit(Op::STOREI, tempAddr);  // p0 => memory[tempAddr]
+            freeTemp(tempAddr);
         }
         break;
     }
 
 
     case CommandKind::IF_THEN: {
-        // children [0]=condition, [1]=commands
-        node.children[0]->accept(*this); // condition => p0 (0 => false)
-        emit("JZERO ???");
-        size_t jzPos = instructions.size()-1;
+        // children [0]=condition, [1]=commands; warunek fałszywy => za blok
+        std::vector<size_t> skipJumps;
+        genCondJump(node.children[0], false, skipJumps);
 
         node.children[1]->accept(*this);
 
-        long long offset = instructions.size() - jzPos;
-        fixupJump(jzPos, offset);
+        for (size_t pos : skipJumps) fixupJump(pos, instructions.size() - pos);
         break;
     }
 
     case CommandKind::IF_THEN_ELSE: {
         // [0]=cond, [1]=then, [2]=else
-        node.children[0]->accept(*this); 
-        emit("JZERO ???");
-        size_t jzPos = instructions.size()-1;
+        // gałąź prawdopodobna zaraz za warunkiem (bez skoku), druga za JUMP
+        bool elseFirst = elseIsLikely(node);
+        ASTNode* first = node.children[elseFirst ? 2 : 1];
+        ASTNode* second = node.children[elseFirst ? 1 : 2];
 
-        node.children[1]->accept(*this);
-        emit("JUMP ???");
-        size_t jmpPos = instructions.size()-1;
+        std::vector<size_t> secondJumps;
+        genCondJump(node.children[0], elseFirst, secondJumps);
 
-        long long offsetElse = instructions.size() - jzPos;
-        fixupJump(jzPos, offsetElse);
+        first->accept(*this);
+        emit(Op::JUMP);
+        size_t jmpPos = instructions.size()-1;
 
-        node.children[2]->accept(*this);
-        long long offsetEnd = instructions.size() - jmpPos;
-        fixupJump(jmpPos, offsetEnd);
+        for (size_t pos : secondJumps) fixupJump(pos, instructions.size() - pos);
+        second->accept(*this);
+        fixupJump(jmpPos, instructions.size() - jmpPos);
         break;
     }
 
     case CommandKind::WHILE: {
         // [0]=cond, [1]=body
-        long long startLab = instructions.size();
-        node.children[0]->accept(*this); 
-        emit("JZERO ???");
-        size_t jzPos = instructions.size()-1;
+        ClosedFormLoop cf;
+        if (!profileGen && analyzeWhileLoop(node, cf)) {
+            genClosedFormWhile(node, cf);
+            break;
+        }
+        // Rotacja: test-strażnik przed pętlą, a na dole skok wstecz wprost na
+        // warunku - bez JUMP na górę i bez materializacji 0/1 w każdym obrocie
+        std::vector<size_t> exitJumps;
+        genCondJump(node.children[0], false, exitJumps);
 
+        long long bodyLab = instructions.size();
+        markLabel();
         node.children[1]->accept(*this);
-        {
-            long long dist = (long long)startLab - (long long)instructions.size();
-            std::ostringstream oss; oss<<"JUMP "<<dist;
-            emit(oss.str());
-        }
-        long long offsetEnd = instructions.size() - jzPos;
-        fixupJump(jzPos, offsetEnd);
+
+        std::vector<size_t> backJumps;
+        genCondJump(node.children[0], true, backJumps);
+        for (size_t pos : backJumps) fixupJump(pos, bodyLab - (long long)pos);
+        for (size_t pos : exitJumps) fixupJump(pos, instructions.size() - pos);
         break;
     }
 
     case CommandKind::REPEAT_UNTIL: {
-        // [0]=body, [1]=cond
+        // [0]=body, [1]=cond; warunek fałszywy => skok wstecz wprost z testu
         long long startLab = instructions.size();
+        markLabel();
         node.children[0]->accept(*this);
-        node.children[1]->accept(*this);
-        {
-            long long dist = (long long)startLab - (long long)instructions.size();
-            std::ostringstream oss; 
-            oss << "JZERO " << dist;
-            emit(oss.str());
-        }
-        break;
-    }
-
-    case CommandKind::FOR_UP: {
-        // [0]=iter, [1]=fromVal, [2]=toVal, [3]=body
-
-        // 1. Zainicjalizuj iterator (z node.children[0])
-        auto* idn = dynamic_cast<IdentifierNode*>(node.children[0]);
-        SymbolInfo si1;
-        if (idn) {
-            si1.kind = SymbolKind::VAR;
-            si1.name = idn->name;
-            si1.isForIterator = true;
-            si1.initialized = true;
-            si1.ownerProcName = currentProcedure;
-            symTab.addLocalSymbol(si1, idn->getLine());
-        }
-        SymbolInfo* si = getSymbol(idn->name);
-        if (si->addr < 1) si->addr = memmgr.allocate(1);
-
-        // 2. Załaduj wartość "from"
-        //    p0 = fromVal
-        node.children[1]->accept(*this);
-        //    iter = fromVal
-        emit(retStore(si->addr, si->ifParam));
-
-        // 3. Załaduj wartość "to"
-        long long limitAddr = memmgr.allocate(1);
-        node.children[2]->accept(*this);
-        {
-            std::ostringstream oss;
-            oss << "STORE " << limitAddr;
-            emit(oss.str());
-        }
-
-        // 4. Oblicz różnicę: (limit = toVal - fromVal)
-        //    p0 = memory[limitAddr]
-        emit(retLoad(limitAddr, false));
-        {
-            std::ostringstream oss;
-            // p0 = p0 - memory[iter]
-            oss << "SUB " << si->addr;
-            emit(oss.str());
-        }
-
-        // 5. Zacznij pętlę — zapisz różnicę do limitAddr i sprawdź, czy < 0
-        long long startLab = instructions.size();
-        {
-            std::ostringstream oss;
-            oss << "STORE " << limitAddr;
-            emit(oss.str());
-        }
-        emit("JNEG ???");  // jeśli różnica < 0, wychodzimy z pętli
-        size_t jnegPos = instructions.size() - 1;
-
-        // 6. Ciało pętli
-        node.children[3]->accept(*this);
-
-        emit("SET 1");
-        emit("ADD " + std::to_string(si->addr));
-        emit(retStore(si->addr, false));
-
-        // 7. Zmniejsz różnicę o 1 — (limit = limit - 1)
-        emit("SET -1");
-        {
-            std::ostringstream oss;
-            // p0 = -1 + memory[limitAddr]
-            oss << "ADD " << limitAddr;
-            emit(oss.str());
-        }
-        emit(retStore(limitAddr, false));
-
-        // 8. Skocz do sprawdzania na początku pętli
-        {
-            long long dist = (long long)startLab - (long long)instructions.size() + 1;
-            std::ostringstream oss; 
-            oss << "JUMP " << dist;
-            emit(oss.str());
-        }
-
-        // 9. Popraw skok warunku (JNEG ???)
-        long long offsetEnd = instructions.size() - jnegPos;
-        fixupJump(jnegPos, offsetEnd);
-
-        if (idn) {
-            symTab.removeLocalSymbol(idn->name, currentProcedure);
-        }
 
+        std::vector<size_t> backJumps;
+        genCondJump(node.children[1], false, backJumps);
+        for (size_t pos : backJumps) fixupJump(pos, startLab - (long long)pos);
         break;
     }
 
+    case CommandKind::FOR_UP:
     case CommandKind::FOR_DOWN: {
-        auto* idn = dynamic_cast<IdentifierNode*>(node.children[0]);
-        SymbolInfo si1;
-        if (idn) {
-            si1.kind = SymbolKind::VAR;
-            si1.name = idn->name;
-            si1.isForIterator = true;
-            si1.initialized = true;
-            si1.ownerProcName = currentProcedure;
-            symTab.addLocalSymbol(si1, idn->getLine());
-        }
-        SymbolInfo* si = getSymbol(idn->name);
-        if (si->addr < 1) si->addr = memmgr.allocate(1);
-
-        // 2. Załaduj wartość "from"
-        //    p0 = fromVal
-        node.children[1]->accept(*this);
-        //    iter = fromVal
-        emit(retStore(si->addr, si->ifParam));
-
-        // 3. Załaduj wartość "to"
-        long long limitAddr = memmgr.allocate(1);
-        node.children[2]->accept(*this);
-        {
-            std::ostringstream oss;
-            oss << "STORE " << limitAddr;
-            emit(oss.str());
-        }
-
-        // 4. Oblicz różnicę: (limit = toVal - fromVal)
-        //    p0 = memory[limitAddr]
-        emit(retLoad(si->addr, false));
-        {
-            std::ostringstream oss;
-            // p0 = p0 - memory[iter]
-            oss << "SUB " << limitAddr;
-            emit(oss.str());
-        }
-
-        // 5. Zacznij pętlę — zapisz różnicę do limitAddr i sprawdź, czy < 0
-        long long startLab = instructions.size();
-        // {
-        //     std::ostringstream oss;
-        //     oss << "STORE " << si->addr;
-        //     emit(oss.str());
-        // }
-        emit("JNEG ???");  // jeśli różnica < 0, wychodzimy z pętli
-        size_t jnegPos = instructions.size() - 1;
-
-        // 6. Ciało pętli
-        node.children[3]->accept(*this);
-
-        // 7. Zmniejsz różnicę o 1 — (limit = limit - 1)
-        emit("SET -1");
-        {
-            std::ostringstream oss;
-            // p0 = -1 + memory[limitAddr]
-            oss << "ADD " << si->addr;
-            emit(oss.str());
-        }
-        emit(retStore(si->addr, false));
-
-        // 8. Skocz do sprawdzania na początku pętli
-        {
-            long long dist = (long long)startLab - (long long)instructions.size() - 1;
-            std::ostringstream oss; 
-            oss << "JUMP " << dist;
-            emit(oss.str());
+        // [0]=iter, [1]=fromVal, [2]=toVal, [3]=body
+        ClosedFormLoop cf;
+        if (!profileGen && analyzeForLoop(node, cf)) {
+            genClosedFormFor(node, cf);
+            break;
         }
-
-        // 9. Popraw skok warunku (JNEG ???)
-        long long offsetEnd = instructions.size() - jnegPos;
-        fixupJump(jnegPos, offsetEnd);
-
-        if (idn) {
-            symTab.removeLocalSymbol(idn->name, currentProcedure);
+        std::vector<size_t> failJumps;
+        genHoistedChecks(node, failJumps);
+        genCountedLoop(node);
+        if (!failJumps.empty()) {
+            // zakres iteratora wychodzi poza tablicę => ta sama pętla z kontrolą
+            // przy każdym dostępie (pułapka dokładnie tam, gdzie bez wyniesienia)
+            emit(Op::JUMP);
+            size_t endPos = instructions.size() - 1;
+            for (size_t pos : failJumps) fixupJump(pos, instructions.size() - pos);
+            bool saved = hoistChecks;
+            hoistChecks = false; // bez kolejnych kopii pętli zagnieżdżonych
+            genCountedLoop(node);
+            hoistChecks = saved;
+            fixupJump(endPos, instructions.size() - endPos);
         }
-
         break;
     }
 
@@ -714,34 +1715,19 @@ void CodeGenVisitor::visit(CommandNode &node) {
 
     case CommandKind::READ: {
         auto* idn = dynamic_cast<IdentifierNode*>(node.children[0]);
-        emit("GET 0"); // read into p0
-        SymbolInfo* si = getSymbol(idn->name);
+        SymbolInfo* si = getSymbol(*idn);
         if (!idn->indexExpr) {
+            emit(Op::GET, 0); // read into p0
             // Use retStore for simple var
             // emit(retStore(si->addr, si->ifParam));
-            emit("STORE " + std::to_string(si->addr));
+            emit(Op::STORE, si->addr);
         } else {
-            long long temp = allocateTemp();
-            emit("STORE " + std::to_string(temp));  // p0 => temp
-            idn->indexExpr->accept(*this);  // oblicz index => p0
-            if (si->ifParam) {
-                long long temp2 = allocateTemp();
-                emit("STORE " + std::to_string(temp2));  // p0 => temp2
-                emit("LOAD " + std::to_string(si->addr));
-                emit("ADD " + std::to_string(temp2));
-                emit("STORE " + std::to_string(temp2));
-                emit("LOAD " + std::to_string(temp));
-                emit("STOREI " + std::to_string(temp2));
-                freeTemp(temp2);
-            }
-            else {
-                genArrOffset(si->addr, si->lowerBound, si->ifParam);
-                long long temp2 = allocateTemp();
-                emit("STORE " + std::to_string(temp2));  // p0 => temp2
-                emit("LOAD " + std::to_string(temp));  // temp => p0
-                emit("STOREI " + std::to_string(temp2));  // p0 => memory[temp2] 
-            }
-            freeTemp(temp);
+            long long tempAddr = allocateTemp();
+            genArrAddress(*idn, si);
+            emit(Op::STORE, tempAddr);
+            emit(Op::GET, 0); // read into p0
+            emit(Op::STOREI, tempAddr);  // p0 => memory[tempAddr]
+            freeTemp(tempAddr);
         }
         break;
     }
@@ -749,7 +1735,7 @@ void CodeGenVisitor::visit(CommandNode &node) {
     case CommandKind::WRITE: {
         // [0]= value => p0
         node.children[0]->accept(*this);
-        emit("PUT 0");
+        emit(Op::PUT, 0);
         break;
     }
 
@@ -768,7 +1754,8 @@ void CodeGenVisitor::visit(ArgsDeclNode &node) {
         SymbolInfo* si = getSymbol(node.argNames[i]);
         if (si->addr < 1) {
             if (si->kind == SymbolKind::ARR) {
-                si->addr = memmgr.allocate(1); // tylko jedna komórka – pass-by-reference
+                // tylko wskaźnik – pass-by-reference (+ granice [lo, hi] przy checkBounds)
+                si->addr = memmgr.allocate(checkBounds ? 3 : 1);
             } else {
                 si->addr = memmgr.allocate(1);
             }
@@ -794,197 +1781,134 @@ void CodeGenVisitor::visit(ProcCallNode &node) {
         SymbolInfo* si2 = getSymbol(an->varNames[i]);
         if (si2->kind == SymbolKind::VAR) {
             // Dla zwykłych zmiennych – kopiujemy wartość
-            emit("LOAD " + std::to_string(si2->addr));
+            emitLoad(si2->addr);
             emit(retStore(si->paramAddrs[i], false));
         } else if (si2->kind == SymbolKind::ARR) {
             // Dla tablic przekazywanych przez referencję – kopiujemy tylko wskaźnik (adres)
-            emit("SET " + std::to_string(si2->addr));
+            // (tablica-parametr już trzyma wskaźnik w swojej komórce => przekazujemy go dalej)
+            if (si2->ifParam)
+                emit(Op::LOAD, si2->addr);
+            else {
+                layout.memAddrSets[lineCounter] = si2->addr + si2->lowerBound;
+                emit(Op::SET, si2->addr);
+            }
             // emit(retStore(si->paramAddrs[i], true));
-            emit("STORE " + std::to_string(si->paramAddrs[i]));
+            emit(Op::STORE, si->paramAddrs[i]);
+            if (checkBounds) {
+                long long cells = boundCells(si2);
+                emit(Op::LOAD, cells);
+                emit(Op::STORE, si->paramAddrs[i] + 1);
+                emit(Op::LOAD, cells + 1);
+                emit(Op::STORE, si->paramAddrs[i] + 2);
+            }
         }
     }
     long long ret = lineCounter + 3;
-    emit("SET " + std::to_string(ret));
+    layout.codeAddrSets.insert(lineCounter);
+    emit(Op::SET, ret);
     emit(retStore(si->returnAddr, false));
-    long long procStartPos = si->addr;
-    long long jumpDist = procStartPos - lineCounter;
-    emit("JUMP " + std::to_string(jumpDist));
+    if (frame > 0) {
+        // początek procedury znany dopiero po łączeniu
+        callFixups.push_back({instructions.size(), si});
+        emit(Op::JUMP, 0);
+    } else {
+        long long procStartPos = si->addr;
+        long long jumpDist = procStartPos - lineCounter;
+        emit(Op::JUMP, jumpDist);
+    }
     // Copy-back: dla zwykłych zmiennych kopiujemy wynik z formalnych parametrów z powrotem,
     // dla tablic (pass-by-reference) nie kopiujemy, bo zmiany są widoczne
     for (long long i = 0; i < argsSize; i++) {
         SymbolInfo* si2 = getSymbol(an->varNames[i]);
         if (si2->kind == SymbolKind::VAR) {
-            emit(retLoad(si->paramAddrs[i], false));
-            emit("STORE " + std::to_string(si2->addr));
+            emitLoad(si->paramAddrs[i]);
+            emit(Op::STORE, si2->addr);
         }
         // Dla tablic (ARR) nic nie kopiujemy z powrotem.
     }
 }
 
 void CodeGenVisitor::visit(ExpressionNode &node) {
-    // Różnica: jeżeli op= "==", "!=", "<", ">", "<=", ">=", 
-    // => generujemy p0= left-right, 
-    // => W CommandNode (IF) sprawdzamy p0 ==0 itp. 
-    // Lub bezpośrednio tu: p0=0 => eq, etc. 
-    node.left->accept(*this);
-    long long tmpA = allocateTemp();
-    emit("STORE " + std::to_string(tmpA));
-
-    node.right->accept(*this);
-    long long tmpB = allocateTemp();
-    emit("STORE " + std::to_string(tmpB));
-
-    // load left => p0
-    emit("LOAD " + std::to_string(tmpA));
-
-    // Zakładamy, że condition => p0= 0 => false, !=0 => true
-    // Gdy op= +, -, * / % => standard
-    if (node.op == "+") {
-        std::ostringstream oss; 
-        oss<<"ADD "<< tmpB;
-        emit(oss.str());
-    } else if (node.op == "-") {
-        std::ostringstream oss;
-        oss<<"SUB "<<tmpB;
-        emit(oss.str());
-    } else if (node.op == "*") {
-        genMultiply(tmpB);
-    } else if (node.op == "/") {
-        genDivision(tmpB, false);
-    } else if (node.op == "%") {
-        genDivision(tmpB, true);
-    }
-    else if (node.op == "==") {
-        // p0= (left-right)
-        // 0 => eq, !=0 => !eq
-        std::ostringstream oss;
-        oss<<"SUB "<<tmpB;
-        emit(oss.str());
-        emit("JZERO 3");
-        emit("SET 0");
-        emit("JUMP 2");
-        emit("SET 1");
-
-    }
-    else if (node.op == "!=") {
-        // p0= (left-right)
-        // 0 => eq, !=0 => !eq
-        // final interpretacja: p0=0 => eq => false, p0!=0 => true => (IF "JZERO skip")
-        // w CommandNode(IF) => "JZERO" => means eq => skip
-        std::ostringstream oss; 
-        oss<<"SUB "<<tmpB;
-        emit(oss.str());
-        emit("JZERO 3");
-        emit("SET 1");
-        emit("JUMP 2");
-        emit("SET 0");
-    }
-    else if (node.op == "<") {
-        // p0= (left-right)
-        // p0<0 => true, p0>=0 => false
-        // w Command IF => "JNEG ???"
-        std::ostringstream oss; 
-        oss<<"SUB "<<tmpB;
-        emit(oss.str());
-        emit("JNEG 3");
-        emit("SET 0");
-        emit("JUMP 2");
-        emit("SET 1");
-    }
-    else if (node.op == ">") {
-        // p0= (left-right)
-        // p0>0 => true => "JPOS ???"
-        std::ostringstream oss;
-        oss<<"SUB "<<tmpB;
-        emit(oss.str());
-        emit("JPOS 3");
-        emit("SET 0");
-        emit("JUMP 2");
-        emit("SET 1");
-    }
-    else if (node.op == "<=") {
-        // p0= (left-right)
-        // p0<=0 => true => "JNEG ??? or JZERO ???"
-        // final interpretacja w CommandNode jest tricky
-        std::ostringstream oss; 
-        oss<<"SUB "<<tmpB;
-        emit(oss.str());
-        emit("JPOS 3");
-        emit("SET 1");
-        emit("JUMP 2");
-        emit("SET 0");
-    }
-    else if (node.op == ">=") {
-        // p0= (left-right)
-        // p0>=0 => true => "JPOS ??? or JZERO ???"
-        std::ostringstream oss;
-        oss<<"SUB "<<tmpB;
-        emit(oss.str());
-        emit("JNEG 3");
-        emit("SET 1");
-        emit("JUMP 2");
-        emit("SET 0");
-    }
-
-    freeTemp(tmpA);
-    freeTemp(tmpB);
+    // Arytmetyka => p0 = wynik. Relacje => p0 = left - right, potem 0/1
+    // (IF/REPEAT testują p0 przez JZERO; WHILE skacze wprost - genCondJump).
+    bool relational = !(node.op == "+" || node.op == "-" || node.op == "*"
+                        || node.op == "/" || node.op == "%");
+    genBinary(relational ? "-" : node.op, node.left, node.right);
+    if (!relational) return;
+
+    if (node.op == "==") {
+        emit(Op::JZERO, 3);
+        emit(Op::SET, 0);
+        emit(Op::JUMP, 2);
+        emit(Op::SET, 1);
+    } else if (node.op == "!=") {
+        emit(Op::JZERO, 3);
+        emit(Op::SET, 1);
+        emit(Op::JUMP, 2);
+        emit(Op::SET, 0);
+    } else if (node.op == "<") {
+        emit(Op::JNEG, 3);
+        emit(Op::SET, 0);
+        emit(Op::JUMP, 2);
+        emit(Op::SET, 1);
+    } else if (node.op == ">") {
+        emit(Op::JPOS, 3);
+        emit(Op::SET, 0);
+        emit(Op::JUMP, 2);
+        emit(Op::SET, 1);
+    } else if (node.op == "<=") {
+        emit(Op::JPOS, 3);
+        emit(Op::SET, 1);
+        emit(Op::JUMP, 2);
+        emit(Op::SET, 0);
+    } else if (node.op == ">=") {
+        emit(Op::JNEG, 3);
+        emit(Op::SET, 1);
+        emit(Op::JUMP, 2);
+        emit(Op::SET, 0);
+    }
 }
 
 void CodeGenVisitor::visit(ValueNode &node) {
-    std::ostringstream oss; 
-    oss << "SET " << node.val;
-    emit(oss.str());
+    emitSet(node.val);
 }
 
 void CodeGenVisitor::visit(IdentifierNode &node) {
-    SymbolInfo* si = getSymbol(node.name);
-    if (!node.indexExpr) {
-        // Zwykła zmienna
-        emit(retLoad(si->addr, si->ifParam));
+    SymbolInfo* si = getSymbol(node);
+    long long addr;
+    if (directAddress(&node, addr)) {
+        // Zwykła zmienna albo element o stałym indeksie
+        emitLoad(addr);
     } else {
-        if(si->ifParam){
-            emit("LOAD " + std::to_string(si->addr));
-            long long temp = allocateTemp();
-            emit("STORE " + std::to_string(temp));
-            node.indexExpr->accept(*this);
-            emit("ADD " + std::to_string(temp));
-            emit("STORE " + std::to_string(temp));
-            emit("LOADI " + std::to_string(temp));
-            freeTemp(temp);
-        }
-        else {
-            long long temp = allocateTemp();
-            node.indexExpr->accept(*this);
-            genArrOffset(si->addr, si->lowerBound, si->ifParam);
-            emit("STORE " + std::to_string(temp));
-            emit("LOADI " + std::to_string(temp));
-            freeTemp(temp);
-        }
         // Tablica: arr[i]
-        //node.indexExpr->accept(*this);
+        long long temp = allocateTemp();
+        genArrAddress(node, si);
+        emit(Op::STORE, temp);
+        emit(Op::LOADI, temp);
+        freeTemp(temp);
     }
 }
 
 
-std::string CodeGenVisitor::retLoad(long long addr, bool param) {
-    return "LOAD " + std::to_string(addr);
+Instr CodeGenVisitor::retLoad(long long addr, bool param) {
+    return {Op::LOAD, addr};
     if (param)
-        return "LOADI " + std::to_string(addr);
+        return {Op::LOADI, addr};
     else
-        return "LOAD " + std::to_string(addr);
+        return {Op::LOAD, addr};
 }
 
-std::string CodeGenVisitor::retStore(long long addr, bool param) {
-    return "STORE " + std::to_string(addr);
+Instr CodeGenVisitor::retStore(long long addr, bool param) {
+    return {Op::STORE, addr};
     if (param)
-        return "STOREI " + std::to_string(addr);
+        return {Op::STOREI, addr};
     else
-        return "STORE " + std::to_string(addr);
+        return {Op::STORE, addr};
 }
-std::string CodeGenVisitor::retAdd(long long addr, bool param) {
-    return param ? ("ADDI " + std::to_string(addr)) : ("ADD " + std::to_string(addr));
+Instr CodeGenVisitor::retAdd(long long addr, bool param) {
+    return {param ? Op::ADDI : Op::ADD, addr};
 }
 
-std::string CodeGenVisitor::retSub(long long addr, bool param) {
-    return param ? ("SUBI " + std::to_string(addr)) : ("SUB " + std::to_string(addr));
+Instr CodeGenVisitor::retSub(long long addr, bool param) {
+    return {param ? Op::SUBI : Op::SUB, addr};
 }
\ No newline at end of file
@@ -4,52 +4,123 @@
 #include "ast.hpp"
 #include "symtable.hpp"
 #include "memory_manager.hpp"
+#include "partial_eval.hpp"
+#include "loop_analysis.hpp"
+#include "code_folding.hpp"
+#include "profile.hpp"
+#include "proc_cache.hpp"
+#include "instruction.hpp"
 
 #include <vector>
+#include <map>
+#include <memory>
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <cstdint>
 
 class CodeGenVisitor : public ASTVisitor {
 public:
     SymbolTable &symTab;       ///< Twoja tablica symboli z polami: kind, addr, lowerBound, upperBound ...
     MemoryManager memmgr;      ///< menedżer pamięci (przydział/zwolnienie)
-    std::string currentProcedure;
+    Name currentProcedure;
 
     long long lineCounter = 1; ///< licznik linii kodu
 
-    std::vector<std::string> instructions; ///< finalny kod maszynowy (w wierszach)
+    Code instructions; ///< finalny kod maszynowy (zapis: CodeWriter)
+
+    const PartialEvaluator* prefixEval = nullptr; ///< prefiks main policzony w czasie kompilacji (opcjonalnie)
+
+    CodeLayout layout; ///< adresy w operandach SET i przedziały procedur (dla code_folding)
+
+    const Profile* profile = nullptr; ///< numery bloków i (przy --profile-use) ich liczniki
+    bool profileGen = false;          ///< wstawiaj liczniki bloków (--profile-gen)
+    bool checkBounds = false;         ///< kontrola zakresu indeksów tablic (--check-bounds)
+    unsigned jobs = 1;                ///< wątki generacji procedur (0 => liczba rdzeni)
+    ProcCache* procCache = nullptr;   ///< kod procedur z wcześniejszych kompilacji (serwer), nullptr => bez
 
     // Konstruktor:
     CodeGenVisitor(SymbolTable &st)
-      : symTab(st), lineCounter(1), currentProcedure("")
-    {std::cout << memmgr.getNextAddress() << " start constr value" << std::endl;}
-
-    // Zwraca finalny kod w formie jednego stringa
-    std::string getCode();
+      : symTab(st), currentProcedure(""), lineCounter(1)
+    {}
 
     // Dodajemy jedną linię kodu
-    void emit(const std::string &cmd);
+    void emit(Op op, long long arg = 0);
+    void emit(const Instr &in);
     void insertFirstJump();
 
+    // ========== Śledzenie zawartości p0 (pomijanie zbędnych LOAD/SET) =============
+    void emitLoad(long long addr);   // LOAD addr, chyba że p0 już równe mem[addr]
+    void emitSet(long long value);   // SET value, chyba że p0 już równe value
+    void markLabel();                // tu wraca skok wstecz => stan nieznany
+
     // ========== Metody alokacji / zwalniania =============
     long long allocateTemp();
     void freeTemp(long long addr);
 
     // ========== Metody pomocnicze do generowania logarytmicznej arytmetyki =============
     void genMultiply(long long memY);        // p0 *= memY => p0
+    void genSquare();                        // p0 *= p0
+    void genMultiplyLoop(bool withSign);     // wspólna pętla po bitach tmpY
+    bool genConstMultiply(ASTNode* left, long long c); // x*c bez pętli (c = 0, ±2^k); false => nie da się
     void genDivision(long long memY, bool doMod); // p0 = p0 / memY lub p0 = p0 % memY
 
     // ========== Obsługa tablic (dynamiczny offset) =========
     void genArrOffset(long long base, long long lb, bool ifParam); // w p0 index => p0= base + (p0-lb)
+    void genArrAddress(IdentifierNode &node, SymbolInfo* si);      // p0 = adres elementu node[index]
+
+    // ========== Kontrola zakresu (checkBounds) =============
+    // Każda tablica ma komórki [lo, hi]: lokalna tuż przed danymi, parametr tuż za wskaźnikiem
+    long long boundCells(SymbolInfo* si) const;
+    void genBoundCheck(SymbolInfo* si);        // p0 = indeks poza [lo, hi] => pułapka; p0 bez zmian
+    // FOR: jedna kontrola zakresu iteratora przed pętlą dla dostępów z każdego obrotu;
+    // niepowodzenie => skoki failJumps do kopii pętli z kontrolą przy każdym dostępie
+    void genHoistedChecks(CommandNode &node, std::vector<size_t> &failJumps);
 
     // ========== Naprawianie relatywnych skoków =============
-    // Typowy schemat: generujemy "JZERO ???", zapamiętujemy pos, ...
+    // Typowy schemat: generujemy emit(Op::JZERO) (długość 0), zapamiętujemy pos, ...
     void fixupJump(size_t instrPos, long long offset);
 
-    std::string retLoad(long long addr, bool param);
-    std::string retStore(long long addr, bool param);
-    std::string retAdd(long long addr, bool param);
-    std::string retSub(long long addr, bool param);
+    // ========== Wyrażenia: kolejność obliczania (Sethi–Ullman) =============
+    void genBinary(const std::string &op, ASTNode* left, ASTNode* right); // p0 = left op right (arytmetyka)
+    bool directAddress(ASTNode* node, long long &addr); // zmienna / t[stała] => adres komórki
+    int spillNeed(ASTNode* node);                       // ile komórek na odłożone operandy
+    void orderOperands(const std::string &op, ASTNode* &left, ASTNode* &right); // przemienność + / *
+
+    // ========== Skoki warunkowe bez materializacji 0/1 =============
+    // jumpIfTrue: skok gdy warunek prawdziwy (inaczej gdy fałszywy); pozycje skoków => fixups
+    void genCondJump(ASTNode* cond, bool jumpIfTrue, std::vector<size_t> &fixups);
+
+    // ========== Pętla FOR: strażnik, ciało, test na dole =============
+    void genCountedLoop(CommandNode &node);
+
+    // ========== Pętle liczone wzorem zamkniętym (loop_analysis) =============
+    void genClosedFormFor(CommandNode &node, const ClosedFormLoop &cf);
+    void genClosedFormWhile(CommandNode &node, const ClosedFormLoop &cf);
+    void genAccumulate(const AccumulatorRec &rec, long long memN, long long memLo, long long memHi);
+    void genSquareSum(long long memX); // p0 = x(x+1)(2x+1)/6 = 1^2 + ... + x^2
+
+    // ========== Profil wykonania =============
+    void genCounter(ASTNode* block);   // ++licznik bloku (tylko przy profileGen)
+    bool elseIsLikely(CommandNode &node); // profil, a bez niego heurystyka: else częstsze niż then
+
+    // ========== Procedury: osobne bufory (równolegle) + łączenie =============
+    // Każda procedura ma własny generator: kod od linii 0, pamięć w ramce
+    // wirtualnej (numer ramki << kFrameShift). Ramki (powrót, parametry,
+    // zmienne lokalne) układane są po kolei, ciała generowane równolegle,
+    // a linkProcedures ustawia bufory jeden za drugim i przelicza adresy
+    // komórek, SET-y adresów tablic i powrotów oraz skoki wywołań.
+    static const int kFrameShift = 40;
+    void beginProcedure(ProcedureDeclNode &node);   // ramka procedury (bez kodu)
+    void genProcedureBody(ProcedureDeclNode &node); // kod ciała
+
+    // ========== Prefiks policzony przez PartialEvaluator =============
+    void genPrefix(size_t totalCommands); // wypisane wartości + stan pamięci
+
+    Instr retLoad(long long addr, bool param);
+    Instr retStore(long long addr, bool param);
+    Instr retAdd(long long addr, bool param);
+    Instr retSub(long long addr, bool param);
 
     // ========== Metody odwiedzające AST (pełna obsługa) =============
     void visit(ProgramAllNode&) override;
@@ -70,13 +141,61 @@ public:
     void visit(IdentifierNode&) override;
 
 private:
-    // Funkcja do pobrania SymbolInfo:
-    SymbolInfo* getSymbol(const std::string &name);
+    // Generator jednej procedury (ramka wirtualna frameNo >= 1)
+    CodeGenVisitor(const CodeGenVisitor &parent, int frameNo);
+
+    int frame = 0; ///< 0 => adresy rzeczywiste; k => ramka wirtualna procedury k
+    std::vector<std::pair<size_t, SymbolInfo*>> callFixups; ///< (pozycja JUMP, wołana procedura)
+    std::vector<long long> frameBases; ///< rzeczywisty początek ramki k (indeks k - 1), po łączeniu
+
+    static long long frameOf(long long addr);  // numer ramki wirtualnej adresu (0 => rzeczywisty)
+    long long relocate(long long addr) const; // adres z ramki wirtualnej => rzeczywisty
+    void linkProcedures(std::vector<std::unique_ptr<CodeGenVisitor>> &units,
+                        const std::vector<ProcedureDeclNode*> &decls);
+
+    // Pamięć podręczna procedur (po beginProcedure, w generatorze procedury).
+    // owned: indeksy symboli procedury (bez PROC) w kolejności tablicy;
+    // procFrames: procedura => numer jej ramki w bieżącym programie.
+    std::string procFingerprint(ProcedureDeclNode &node, const std::vector<int> &owned);
+    void saveProcedure(CachedProcedure &out, const std::vector<int> &owned,
+                       const std::unordered_map<Name, long long> &procFrames) const;
+    void restoreProcedure(const CachedProcedure &in, const std::vector<int> &owned,
+                          const std::unordered_map<Name, long long> &procFrames);
 
-    // Pomocnicza do generowania unikalnych etykiet:
-    std::string makeLabel(const std::string &prefix);
-
-    long long labelCounter = 0;
+    // Funkcja do pobrania SymbolInfo:
+    SymbolInfo* getSymbol(IdentifierNode &idn); // indeks z analizy semantycznej
+    SymbolInfo* getSymbol(Name name);
+
+    // Co wiadomo o p0 w bieżącym miejscu kodu
+    struct AccState {
+        bool knownConst = false;
+        long long value = 0;
+        std::set<long long> cells; // komórki równe p0
+    };
+    AccState acc;
+    std::set<long long> pendingTargets; ///< przyszłe cele skoków w przód o stałej długości
+
+    void forgetAcc();
+
+    // Komórki na odłożone operandy: poziom zagnieżdżenia => komórka (wielokrotnie używane)
+    std::vector<long long> spillSlots;
+    long long spillDepth = 0;
+    long long acquireSpill();
+    void releaseSpill();
+    void trackAcc(Op op, long long arg, long long pos);
+
+    long long mulScratch = -1; ///< 5 komórek roboczych genMultiply
+    long long divScratch = -1; ///< 10 komórek roboczych genDivision
+    long long counterBase = -1; ///< liczniki bloków profilu (profileGen)
+    long long oneCell = -1;     ///< stała 1 (krok pętli FOR), ustawiana na początku main
+
+    long long boundIdx = -1;      ///< indeks sprawdzany (wypisywany przez pułapkę)
+    long long boundTmp = -1;      ///< górna granica iteratora przy kontroli wyniesionej
+    std::vector<size_t> trapJumps; ///< skoki do wspólnej pułapki za HALT
+    std::vector<std::pair<long long, long long>> boundInits; ///< (komórka, wartość) granic tablic lokalnych
+    std::map<Name, std::set<SymbolInfo*>> checkedIters; ///< iterator => tablice sprawdzone przed pętlą
+    std::map<Name, SymbolInfo*> openIters; ///< iteratory pętli, w których ciele jesteśmy
+    bool hoistChecks = true;      ///< false w zapasowej kopii pętli (bez wynoszenia kontroli)
 };
 
 #endif
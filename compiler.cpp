@@ -0,0 +1,154 @@
+#include "compiler.hpp"
+#include "ast.hpp"
+#include "parse_context.hpp"
+#include "semantic_visitor.hpp"
+#include "ast_print.cpp"
+#include "codegen_visitor.hpp"
+#include "partial_eval.hpp"
+#include "proc_specializer.hpp"
+#include "dead_store.hpp"
+#include "scalar_replace.hpp"
+#include "loop_fusion.hpp"
+#include "profile.hpp"
+#include "mapped_file.hpp"
+#include "code_writer.hpp"
+
+#include <cstdio>
+#include <iostream>
+
+int compileProgram(const std::string &srcPath, const std::string &outPath, CompileOptions opts,
+                   std::ostream &log, std::ostream &err) {
+    // Otwieramy plik wejściowy (mapowanie, bez kopii przez stdio)
+    MappedFile src;
+    if (!src.open(srcPath)) {
+        err << "Nie można otworzyć pliku " << srcPath << "\n";
+        return 2;
+    }
+
+    Code finalCode;
+    int res = compileSource(src.data(), src.size(), opts, finalCode, log, err);
+    if (res != 0) return res;
+
+    return writeCode(outPath, finalCode, log, err);
+}
+
+int compileSource(const char* src, size_t size, CompileOptions opts, Code &code,
+                  std::ostream &log, std::ostream &err, ProcCache* procCache) {
+    // Całe drzewo programu żyje w jednej arenie, zwalnianej na końcu kompilacji
+    Arena astArena;
+    ArenaScope arenaScope(astArena);
+
+    // Parsowanie
+    ParseContext parseCtx;
+    parseCtx.diag = &err;
+    int parseRes;
+    if (opts.flexLexer) {
+        // fmemopen nie przyjmuje pustego wskaźnika, src zawsze jest poprawny
+        FILE* f = fmemopen(const_cast<char*>(src), size, "r");
+        if (!f) {
+            err << "Nie można odczytać źródła\n";
+            return 2;
+        }
+        parseRes = parseProgram(f, parseCtx);
+        fclose(f);
+    } else {
+        parseRes = parseBuffer(src, size, parseCtx);
+    }
+    ASTNode* root = parseCtx.root;
+    
+    if (parseRes != 0) {
+        err << "Błąd parsowania!\n";
+        return 3;
+    }
+    if (!root) {
+        err << "AST nie powstało\n";
+        return 4;
+    }
+    
+    // Wypisujemy AST (opcjonalnie)
+    // printAST(root);
+    
+    log << "Parsowanie OK. Teraz analiza semantyczna...\n";
+    
+    // Analiza semantyczna
+    SemanticVisitor visitor;
+    visitor.symTab.diag = &err;
+    visitor.analyze(root);
+    
+    if (visitor.symTab.errors > 0) {
+        err << "Wykryto " << visitor.symTab.errors 
+                  << " błędów semantycznych.\n";
+        return 5;
+    }
+    
+    log << "Analiza semantyczna OK. Możemy generować kod.\n";
+
+    // Numery bloków profilu: przed przekształceniami, więc zgodne w obu trybach
+    Profile profile;
+    profile.assignIds(root);
+    if (opts.profileGen) {
+        // liczniki mają opisywać program źródłowy: bez liczenia w czasie kompilacji i klonów
+        opts.peStepBudget = 0;
+        opts.cloneBudget = 0;
+    } else if (!opts.profileUse.empty()) {
+        profile.load(opts.profileUse, err);
+    }
+    const Profile* usedProfile = profile.loaded() ? &profile : nullptr;
+
+    // Klony procedur dla stałych argumentów
+    ProcedureSpecializer specializer(visitor, opts.cloneBudget, usedProfile);
+    specializer.run(root);
+
+    // t[stała] => osobne zmienne (także w klonach)
+    if (opts.scalarReplace) {
+        ScalarReplacer sra(visitor.symTab);
+        sra.run(root);
+    }
+
+    // Sąsiednie FOR o tych samych granicach => jedna pętla
+    if (opts.loopFusion) {
+        LoopFuser fuser;
+        fuser.run(root);
+    }
+
+    // Przypisania, których wyniku nic nie czyta
+    if (opts.deadStores) {
+        DeadStoreEliminator dse;
+        dse.run(root);
+    }
+
+    // Generacja kodu
+    SymbolTable& symTab = visitor.symTab;
+    // Część main niezależna od wejścia => liczymy od razu
+    PartialEvaluator prefix(symTab, opts.peStepBudget);
+    prefix.run(root);
+
+    CodeGenVisitor codeGen(symTab);
+    codeGen.prefixEval = &prefix;
+    codeGen.profileGen = opts.profileGen;
+    codeGen.checkBounds = opts.checkBounds;
+    codeGen.jobs = opts.jobs;
+    codeGen.procCache = procCache;
+    codeGen.profile = opts.profileGen ? &profile : usedProfile;
+    root->accept(codeGen);
+    postprocessCode(codeGen.instructions, codeGen.layout, opts.deadStores, opts.foldCode);
+    code.swap(codeGen.instructions);
+    return 0;
+}
+
+int writeCode(const std::string &outPath, const Code &code,
+              std::ostream &log, std::ostream &err) {
+    // Zapisujemy kod do pliku wyjściowego (tekst powstaje dopiero w buforze zapisu)
+    CodeWriter out;
+    if (!out.open(outPath)) {
+        err << "Błąd: Nie można otworzyć pliku do zapisu." << std::endl;
+        return 6;
+    }
+    out.write(code);
+    if (!out.close()) {
+        err << "Błąd: Nie udało się zapisać pliku " << outPath << std::endl;
+        return 6;
+    }
+    log << "Kod został zapisany do " << outPath << std::endl;
+    return 0;
+}
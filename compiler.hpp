@@ -0,0 +1,39 @@
+#ifndef COMPILER_HPP
+#define COMPILER_HPP
+
+#include "options.hpp"
+#include "instruction.hpp"
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+class ProcCache;
+
+//////////////////////////////////////
+// Jedna kompilacja: plik źródłowy => plik z kodem maszyny
+//////////////////////////////////////
+//
+// Cały stan (arena drzewa, kontekst parsera, tablica symboli, generator)
+// jest lokalny dla wywołania, więc można kompilować wiele programów naraz
+// w osobnych wątkach. Wspólna jest tylko tablica nazw (StringTable).
+//
+// Wynik: 0 => OK, dalej kody błędów jak kody wyjścia kompilatora
+// (2 plik wejściowy, 3 parsowanie, 4 brak AST, 5 semantyka, 6 zapis wyniku).
+// Komunikaty o postępie idą do `log`, diagnostyka (także parsera i analizy
+// semantycznej) do `err` — tryb wsadowy podaje tu bufory danego pliku.
+int compileProgram(const std::string &srcPath, const std::string &outPath, CompileOptions opts,
+                   std::ostream &log = std::cout, std::ostream &err = std::cerr);
+
+// Sama kompilacja: źródło z pamięci (`size` bajtów od `src`, bez końcowego
+// zera) => kod maszyny w `code` (bez zapisu). Wynik 0, 3, 4 albo 5 jak wyżej.
+// procCache: kod niezmienionych procedur z wcześniejszych kompilacji (serwer),
+// nullptr => każda generowana od nowa.
+int compileSource(const char* src, size_t size, CompileOptions opts, Code &code,
+                  std::ostream &log, std::ostream &err, ProcCache* procCache = nullptr);
+
+// Zapis gotowego kodu; 0 => OK, 6 => nie da się zapisać
+int writeCode(const std::string &outPath, const Code &code,
+              std::ostream &log, std::ostream &err);
+
+#endif // COMPILER_HPP
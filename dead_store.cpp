@@ -0,0 +1,176 @@
+#include "dead_store.hpp"
+
+// ------------------ Użycia ------------------
+
+void DeadStoreEliminator::addUses(ASTNode* expr, LiveSet &live) {
+    if (auto* idn = dynamic_cast<IdentifierNode*>(expr)) {
+        if (idn->indexExpr) addUses(idn->indexExpr, live);
+        else if (!arrays.count(idn->name)) live.insert(idn->name);
+    } else if (auto* e = dynamic_cast<ExpressionNode*>(expr)) {
+        addUses(e->left, live);
+        addUses(e->right, live);
+    }
+}
+
+// ------------------ Przepływ wstecz ------------------
+
+DeadStoreEliminator::LiveSet DeadStoreEliminator::liveCommands(ASTNode* node, const LiveSet &out, bool apply) {
+    auto* cmds = dynamic_cast<CommandsNode*>(node);
+    if (!cmds) return out;
+
+    LiveSet live = out;
+    for (size_t k = cmds->cmdList.size(); k-- > 0;) {
+        auto* cmd = dynamic_cast<CommandNode*>(cmds->cmdList[k]);
+        if (!cmd) continue;
+
+        // x := e, gdy x martwe => całe przypisanie (łącznie z arytmetyką) znika
+        if (cmd->cmdKind == CommandKind::ASSIGN) {
+            auto* target = dynamic_cast<IdentifierNode*>(cmd->children[0]);
+            if (target && !target->indexExpr && !arrays.count(target->name)
+                && !live.count(target->name)) {
+                if (apply) {
+                    delete cmd;
+                    cmds->cmdList.erase(cmds->cmdList.begin() + k);
+                    removed++;
+                }
+                continue;
+            }
+        }
+        live = liveCommand(cmd, live, apply);
+    }
+    return live;
+}
+
+DeadStoreEliminator::LiveSet DeadStoreEliminator::liveLoopBody(ASTNode* body, const LiveSet &base, bool apply) {
+    LiveSet end = base;
+    while (true) {
+        LiveSet next = base;
+        LiveSet in = liveCommands(body, end, false);
+        next.insert(in.begin(), in.end());
+        if (next == end) break;
+        end = next;
+    }
+    if (apply) liveCommands(body, end, true);
+    return end;
+}
+
+DeadStoreEliminator::LiveSet DeadStoreEliminator::liveCommand(CommandNode* cmd, const LiveSet &out, bool apply) {
+    LiveSet live = out;
+    switch (cmd->cmdKind) {
+    case CommandKind::ASSIGN: {
+        auto* target = dynamic_cast<IdentifierNode*>(cmd->children[0]);
+        if (target && !target->indexExpr) live.erase(target->name);
+        else addUses(target, live); // indeks elementu tablicy
+        addUses(cmd->children[1], live);
+        break;
+    }
+    case CommandKind::READ: {
+        auto* target = dynamic_cast<IdentifierNode*>(cmd->children[0]);
+        if (target && !target->indexExpr) live.erase(target->name);
+        else addUses(target, live);
+        break;
+    }
+    case CommandKind::WRITE:
+        addUses(cmd->children[0], live);
+        break;
+    case CommandKind::PROC_CALL: {
+        // copy-in czyta wszystkie argumenty, copy-out je nadpisuje => czytane
+        auto* pc = dynamic_cast<ProcCallNode*>(cmd->children[0]);
+        auto* an = pc ? dynamic_cast<ArgsNode*>(pc->args) : nullptr;
+        if (an) {
+            for (auto &name : an->varNames)
+                if (!arrays.count(name)) live.insert(name);
+        }
+        break;
+    }
+    case CommandKind::IF_THEN:
+    case CommandKind::IF_THEN_ELSE: {
+        LiveSet thenLive = liveCommands(cmd->children[1], out, apply);
+        LiveSet elseLive = (cmd->cmdKind == CommandKind::IF_THEN_ELSE)
+                           ? liveCommands(cmd->children[2], out, apply) : out;
+        live = thenLive;
+        live.insert(elseLive.begin(), elseLive.end());
+        addUses(cmd->children[0], live);
+        break;
+    }
+    case CommandKind::WHILE: {
+        LiveSet base = out;
+        addUses(cmd->children[0], base);
+        live = liveLoopBody(cmd->children[1], base, apply);
+        break;
+    }
+    case CommandKind::REPEAT_UNTIL: {
+        LiveSet base = out;
+        addUses(cmd->children[1], base);
+        LiveSet end = liveLoopBody(cmd->children[0], base, apply);
+        live = liveCommands(cmd->children[0], end, false);
+        break;
+    }
+    case CommandKind::FOR_UP:
+    case CommandKind::FOR_DOWN: {
+        // iterator czyta sterowanie pętli po każdym obrocie
+        LiveSet base = out;
+        auto* iter = dynamic_cast<IdentifierNode*>(cmd->children[0]);
+        if (iter) base.insert(iter->name);
+        live = liveLoopBody(cmd->children[3], base, apply);
+        addUses(cmd->children[1], live);
+        addUses(cmd->children[2], live);
+        break;
+    }
+    }
+    return live;
+}
+
+// ------------------ Przebieg ------------------
+
+void DeadStoreEliminator::runUnit(ASTNode* decls, ASTNode* cmds, const LiveSet &liveAtExit,
+                                  bool staticLocals) {
+    LiveSet exitLive = liveAtExit;
+    LiveSet locals;
+    if (auto* dn = dynamic_cast<DeclarationsNode*>(decls)) {
+        for (auto* d : dn->declList) {
+            if (auto* da = dynamic_cast<DeclarationArrNode*>(d)) arrays.insert(da->arrName);
+            else if (auto* dv = dynamic_cast<DeclarationVarNode*>(d)) locals.insert(dv->varName);
+        }
+    }
+    // Zmienne lokalne procedury są statyczne: lokalna czytana przed
+    // przypisaniem (żywa na wejściu) widzi wartość z poprzedniego wywołania,
+    // więc jest żywa także na końcu. Do punktu stałego, bo zachowane
+    // przypisania ożywiają swoje operandy.
+    while (staticLocals) {
+        LiveSet entry = liveCommands(cmds, exitLive, false);
+        size_t before = exitLive.size();
+        for (auto &name : locals) {
+            if (entry.count(name)) exitLive.insert(name);
+        }
+        if (exitLive.size() == before) break;
+    }
+    liveCommands(cmds, exitLive, true);
+}
+
+void DeadStoreEliminator::run(ASTNode* root) {
+    auto* program = dynamic_cast<ProgramAllNode*>(root);
+    if (!program) return;
+
+    if (auto* procs = dynamic_cast<ProceduresNode*>(program->procedures)) {
+        for (auto* p : procs->procedureDecls) {
+            auto* pd = dynamic_cast<ProcedureDeclNode*>(p);
+            if (!pd) continue;
+            // Parametry zwykłe wracają do wołającego (copy-out) => żywe na końcu
+            arrays.clear();
+            LiveSet exitLive;
+            if (auto* formals = dynamic_cast<ArgsDeclNode*>(pd->argsDecl)) {
+                for (size_t i = 0; i < formals->argNames.size(); i++) {
+                    if (formals->isArray[i]) arrays.insert(formals->argNames[i]);
+                    else exitLive.insert(formals->argNames[i]);
+                }
+            }
+            runUnit(pd->localDecls, pd->commands, exitLive, true);
+        }
+    }
+    if (auto* mn = dynamic_cast<MainNode*>(program->mainPart)) {
+        // po HALT nic nie jest czytane
+        arrays.clear();
+        runUnit(mn->declarations, mn->commands, LiveSet(), false);
+    }
+}
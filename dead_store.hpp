@@ -0,0 +1,37 @@
+#ifndef DEAD_STORE_HPP
+#define DEAD_STORE_HPP
+
+#include "ast.hpp"
+
+#include <set>
+#include <string>
+
+//////////////////////////////////////
+// Usuwanie martwych przypisań (wsteczna analiza żywotności zmiennych)
+//////////////////////////////////////
+class DeadStoreEliminator {
+public:
+    // Przechodzi procedury i main; usuwa ASSIGN do zwykłych zmiennych,
+    // których wartości nic potem nie czyta. READ i wywołania zostają.
+    void run(ASTNode* root);
+
+    long long removed = 0; ///< liczba usuniętych przypisań
+
+private:
+    using LiveSet = std::set<Name>;
+
+    std::set<Name> arrays; ///< tablice bieżącej procedury / main (zawsze żywe)
+
+    // Żywe przed blokiem przy żywych "out" za nim; apply => usuwa martwe przypisania
+    LiveSet liveCommands(ASTNode* node, const LiveSet &out, bool apply);
+    LiveSet liveCommand(CommandNode* cmd, const LiveSet &out, bool apply);
+    // Punkt stały dla ciała pętli: żywe na wejściu ciała, gdy na końcu ciała
+    // żywe są base + to, co żywe na jego wejściu
+    LiveSet liveLoopBody(ASTNode* body, const LiveSet &base, bool apply);
+
+    void addUses(ASTNode* expr, LiveSet &live);
+    // staticLocals: procedura (lokalne zachowują wartość między wywołaniami)
+    void runUnit(ASTNode* decls, ASTNode* cmds, const LiveSet &liveAtExit, bool staticLocals);
+};
+
+#endif // DEAD_STORE_HPP
@@ -0,0 +1,54 @@
+#ifndef INSTRUCTION_HPP
+#define INSTRUCTION_HPP
+
+#include <cstdint>
+#include <vector>
+
+//////////////////////////////////////
+// Instrukcja maszyny wirtualnej w postaci binarnej
+//////////////////////////////////////
+//
+// Generator, przebiegi po generacji i pamięci podręczne trzymają kod jako
+// (kod operacji, operand) — bez napisów na każdą linię. Tekst powstaje
+// dopiero przy zapisie do pliku (CodeWriter).
+enum class Op : uint8_t {
+    GET, PUT, LOAD, STORE, LOADI, STOREI, ADD, SUB, ADDI, SUBI,
+    SET, HALF, JUMP, JPOS, JZERO, JNEG, RTRN, HALT
+};
+
+struct Instr {
+    Op op = Op::HALT;
+    long long arg = 0; ///< komórka / stała / skok względny; skok "do uzupełnienia" => 0
+};
+
+typedef std::vector<Instr> Code;
+
+inline const char* opName(Op op) {
+    static const char* const kNames[] = {
+        "GET", "PUT", "LOAD", "STORE", "LOADI", "STOREI", "ADD", "SUB", "ADDI", "SUBI",
+        "SET", "HALF", "JUMP", "JPOS", "JZERO", "JNEG", "RTRN", "HALT"
+    };
+    return kNames[(int)op];
+}
+
+// HALF i HALT nie mają operandu
+inline bool hasOperand(Op op) {
+    return op != Op::HALF && op != Op::HALT;
+}
+
+inline bool isJumpOp(Op op) {
+    return op == Op::JUMP || op == Op::JPOS || op == Op::JZERO || op == Op::JNEG;
+}
+
+// Operand to adres komórki pamięci
+inline bool isMemoryOp(Op op) {
+    switch (op) {
+    case Op::GET: case Op::PUT: case Op::LOAD: case Op::STORE: case Op::LOADI:
+    case Op::STOREI: case Op::ADD: case Op::SUB: case Op::ADDI: case Op::SUBI: case Op::RTRN:
+        return true;
+    default:
+        return false;
+    }
+}
+
+#endif // INSTRUCTION_HPP
@@ -0,0 +1,94 @@
+#include "intern.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Napisy w blokach stałej wielkości: raz zapisany napis nie zmienia adresu,
+// więc str() czyta bez blokady (numer pochodzi z intern(), które ją bierze).
+// Spis bloków rośnie: nowy (dwa razy większy) publikowany atomowo, stare
+// zostają do końca procesu, bo str() może jeszcze z nich czytać.
+constexpr uint32_t kChunkBits = 12;
+constexpr uint32_t kChunkSize = 1u << kChunkBits;
+constexpr uint32_t kMaxChunks = 1u << (32 - kChunkBits); // numery 32-bitowe
+
+struct Directory {
+    uint32_t capacity;
+    std::unique_ptr<std::string*[]> chunks;
+
+    explicit Directory(uint32_t capacity)
+        : capacity(capacity), chunks(new std::string*[capacity]()) {}
+};
+
+struct Table {
+    std::mutex mutex;
+    std::atomic<const Directory*> dir{nullptr};
+    std::vector<std::unique_ptr<Directory>> dirs;          ///< bieżący i poprzednie spisy
+    std::vector<std::unique_ptr<std::string[]>> storage;   ///< bloki napisów
+    uint64_t count = 0;
+    std::unordered_map<std::string_view, uint32_t> ids;
+
+    Directory* current() { return dirs.back().get(); }
+
+    uint32_t add(const char* s, size_t len) {
+        if (count >= (uint64_t)kMaxChunks * kChunkSize)
+            throw std::length_error("tablica nazw pełna (2^32 identyfikatorów)");
+        uint32_t id = (uint32_t)count;
+        uint32_t k = id >> kChunkBits;
+        if (k >= current()->capacity) {
+            std::unique_ptr<Directory> bigger(new Directory(std::min(current()->capacity * 2, kMaxChunks)));
+            std::copy(current()->chunks.get(), current()->chunks.get() + current()->capacity,
+                      bigger->chunks.get());
+            dirs.push_back(std::move(bigger));
+            dir.store(current(), std::memory_order_release);
+        }
+        if (!current()->chunks[k]) {
+            storage.emplace_back(new std::string[kChunkSize]);
+            current()->chunks[k] = storage.back().get();
+        }
+        std::string &slot = current()->chunks[k][id & (kChunkSize - 1)];
+        slot.assign(s, len);
+        ids.emplace(std::string_view(slot), id);
+        count++;
+        return id;
+    }
+
+    Table() {
+        dirs.emplace_back(new Directory(16));
+        dir.store(current(), std::memory_order_release);
+        add("", 0);
+    }
+};
+
+Table& table() {
+    static Table t;
+    return t;
+}
+
+} // namespace
+
+uint32_t StringTable::intern(const char* s, size_t len) {
+    Table &t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    auto it = t.ids.find(std::string_view(s, len));
+    if (it != t.ids.end()) return it->second;
+    return t.add(s, len);
+}
+
+const std::string& StringTable::str(uint32_t id) {
+    const Directory* d = table().dir.load(std::memory_order_acquire);
+    return d->chunks[id >> kChunkBits][id & (kChunkSize - 1)];
+}
+
+size_t StringTable::size() {
+    Table &t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    return (size_t)t.count;
+}
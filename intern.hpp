@@ -0,0 +1,60 @@
+#ifndef INTERN_HPP
+#define INTERN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+
+//////////////////////////////////////
+// Tablica nazw: każdy identyfikator zapisany raz, dalej tylko jego numer
+//////////////////////////////////////
+//
+// Lekser internuje każdy identyfikator; węzły AST i tablica symboli trzymają
+// Name (32-bitowy numer), więc porównanie i hash to operacje na liczbie.
+// Numer 0 to pusty napis (np. właściciel symboli main). Tablica jest wspólna
+// dla wszystkich kompilacji w procesie; intern() jest bezpieczne wielowątkowo.
+class StringTable {
+public:
+    static uint32_t intern(const char* s, size_t len);
+    static const std::string& str(uint32_t id);
+    static size_t size();
+};
+
+class Name {
+public:
+    Name() : id(0) {}
+    Name(const std::string &s) : id(StringTable::intern(s.data(), s.size())) {}
+    Name(const char* s) : Name(std::string(s)) {}
+
+    static Name fromIndex(uint32_t i) { Name n; n.id = i; return n; }
+
+    uint32_t index() const { return id; }
+    const std::string& str() const { return StringTable::str(id); }
+    operator const std::string&() const { return str(); }
+    bool empty() const { return id == 0; }
+
+    friend bool operator==(Name a, Name b) { return a.id == b.id; }
+    friend bool operator!=(Name a, Name b) { return a.id != b.id; }
+    // Porządek alfabetyczny (stabilny między uruchomieniami)
+    friend bool operator<(Name a, Name b) { return a.id != b.id && a.str() < b.str(); }
+
+private:
+    uint32_t id; ///< indeks w StringTable
+};
+
+inline std::string operator+(const std::string &a, Name b) { return a + b.str(); }
+inline std::string operator+(Name a, const std::string &b) { return a.str() + b; }
+inline std::string operator+(const char* a, Name b) { return a + b.str(); }
+inline std::string operator+(Name a, const char* b) { return a.str() + b; }
+inline std::ostream& operator<<(std::ostream &os, Name n) { return os << n.str(); }
+
+namespace std {
+template <>
+struct hash<Name> {
+    size_t operator()(Name n) const { return n.index(); }
+};
+}
+
+#endif // INTERN_HPP
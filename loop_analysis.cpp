@@ -0,0 +1,173 @@
+#include "loop_analysis.hpp"
+
+#include <set>
+
+// ------------------ Pomocnicze ------------------
+
+// Zwykła zmienna (bez indeksu)
+static IdentifierNode* asScalar(ASTNode* node) {
+    auto* idn = dynamic_cast<IdentifierNode*>(node);
+    return (idn && !idn->indexExpr) ? idn : nullptr;
+}
+
+static bool isNamed(ASTNode* node, Name name) {
+    IdentifierNode* idn = asScalar(node);
+    return idn && !name.empty() && idn->name == name;
+}
+
+// Operand niezmienny w pętli: liczba albo zmienna nieprzypisywana w ciele
+static bool isInvariant(ASTNode* node, const std::set<Name> &assigned,
+                        Name iter) {
+    if (dynamic_cast<ValueNode*>(node)) return true;
+    IdentifierNode* idn = asScalar(node);
+    return idn && idn->name != iter && assigned.count(idn->name) == 0;
+}
+
+// Przyrost: c | i | c*i | i*c | i*i
+static bool matchStep(ASTNode* node, Name iter,
+                      const std::set<Name> &assigned, AccumulatorRec &rec) {
+    if (isInvariant(node, assigned, iter)) {
+        rec.step = AccStep::INVARIANT;
+        rec.factor = node;
+        return true;
+    }
+    if (isNamed(node, iter)) {
+        rec.step = AccStep::ITERATOR;
+        return true;
+    }
+    auto* expr = dynamic_cast<ExpressionNode*>(node);
+    if (!expr || expr->op != "*" || iter.empty()) return false;
+
+    if (isNamed(expr->left, iter) && isNamed(expr->right, iter)) {
+        rec.step = AccStep::SQUARED_ITERATOR;
+        return true;
+    }
+    if (isNamed(expr->right, iter) && isInvariant(expr->left, assigned, iter)) {
+        rec.step = AccStep::SCALED_ITERATOR;
+        rec.factor = expr->left;
+        return true;
+    }
+    if (isNamed(expr->left, iter) && isInvariant(expr->right, assigned, iter)) {
+        rec.step = AccStep::SCALED_ITERATOR;
+        rec.factor = expr->right;
+        return true;
+    }
+    return false;
+}
+
+// acc := acc + krok | acc := krok + acc | acc := acc - krok
+static bool matchRecurrence(Name acc, ASTNode* rhs, Name iter,
+                            const std::set<Name> &assigned, AccumulatorRec &rec) {
+    auto* expr = dynamic_cast<ExpressionNode*>(rhs);
+    if (!expr) return false;
+    rec.acc = acc;
+    if (expr->op == "+" && isNamed(expr->left, acc)) {
+        return matchStep(expr->right, iter, assigned, rec);
+    }
+    if (expr->op == "+" && isNamed(expr->right, acc)) {
+        return matchStep(expr->left, iter, assigned, rec);
+    }
+    if (expr->op == "-" && isNamed(expr->left, acc)) {
+        rec.subtract = true;
+        return matchStep(expr->right, iter, assigned, rec);
+    }
+    return false;
+}
+
+// Ciało = same przypisania do różnych zwykłych zmiennych; zbiera ich nazwy
+static bool collectAssigns(ASTNode* body, std::vector<CommandNode*> &assigns,
+                           std::set<Name> &assigned) {
+    auto* cmds = dynamic_cast<CommandsNode*>(body);
+    if (!cmds || cmds->cmdList.empty()) return false;
+    for (auto* c : cmds->cmdList) {
+        auto* cmd = dynamic_cast<CommandNode*>(c);
+        if (!cmd || cmd->cmdKind != CommandKind::ASSIGN) return false;
+        IdentifierNode* target = asScalar(cmd->children[0]);
+        if (!target || !assigned.insert(target->name).second) return false;
+        assigns.push_back(cmd);
+    }
+    return true;
+}
+
+// ------------------ FOR ------------------
+
+bool analyzeForLoop(CommandNode &node, ClosedFormLoop &out) {
+    if (node.cmdKind != CommandKind::FOR_UP && node.cmdKind != CommandKind::FOR_DOWN)
+        return false;
+    auto* iter = dynamic_cast<IdentifierNode*>(node.children[0]);
+    if (!iter) return false;
+
+    std::vector<CommandNode*> assigns;
+    std::set<Name> assigned;
+    if (!collectAssigns(node.children[3], assigns, assigned)) return false;
+
+    ClosedFormLoop result;
+    for (auto* cmd : assigns) {
+        AccumulatorRec rec;
+        auto* target = asScalar(cmd->children[0]);
+        if (!matchRecurrence(target->name, cmd->children[1], iter->name, assigned, rec))
+            return false;
+        result.recs.push_back(rec);
+    }
+    out = result;
+    return true;
+}
+
+// ------------------ WHILE ------------------
+
+bool analyzeWhileLoop(CommandNode &node, ClosedFormLoop &out) {
+    if (node.cmdKind != CommandKind::WHILE) return false;
+    auto* cond = dynamic_cast<ExpressionNode*>(node.children[0]);
+    if (!cond) return false;
+
+    std::vector<CommandNode*> assigns;
+    std::set<Name> assigned;
+    if (!collectAssigns(node.children[1], assigns, assigned)) return false;
+
+    // Warunek sprowadzamy do "v op bound", gdzie v jest przypisywane w ciele
+    std::string op = cond->op;
+    ASTNode* counterSide = cond->left;
+    ASTNode* boundSide = cond->right;
+    IdentifierNode* v = asScalar(counterSide);
+    if (!v || !assigned.count(v->name)) {
+        std::swap(counterSide, boundSide);
+        v = asScalar(counterSide);
+        if      (op == "<")  op = ">";
+        else if (op == ">")  op = "<";
+        else if (op == "<=") op = ">=";
+        else if (op == ">=") op = "<=";
+    }
+    if (!v || !assigned.count(v->name) || !isInvariant(boundSide, assigned, ""))
+        return false;
+
+    ClosedFormLoop result;
+    result.counter = v->name;
+    result.bound = boundSide;
+    if      (op == "<")  { result.counterStep = 1;  result.inclusive = false; }
+    else if (op == "<=") { result.counterStep = 1;  result.inclusive = true;  }
+    else if (op == ">")  { result.counterStep = -1; result.inclusive = false; }
+    else if (op == ">=") { result.counterStep = -1; result.inclusive = true;  }
+    else return false; // "=" / "!=" - liczba obrotów nieobliczalna wprost
+
+    bool counterSeen = false;
+    for (auto* cmd : assigns) {
+        auto* target = asScalar(cmd->children[0]);
+        AccumulatorRec rec;
+        if (!matchRecurrence(target->name, cmd->children[1], "", assigned, rec)
+            || rec.step != AccStep::INVARIANT)
+            return false;
+
+        if (target->name == result.counter) {
+            // licznik: v := v + 1 / v := v - 1 zgodnie z kierunkiem warunku
+            auto* one = dynamic_cast<ValueNode*>(rec.factor);
+            long long step = one ? (rec.subtract ? -one->val : one->val) : 0;
+            if (step != result.counterStep) return false;
+            counterSeen = true;
+        } else {
+            result.recs.push_back(rec);
+        }
+    }
+    if (!counterSeen) return false;
+    out = result;
+    return true;
+}
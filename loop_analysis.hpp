@@ -0,0 +1,46 @@
+#ifndef LOOP_ANALYSIS_HPP
+#define LOOP_ANALYSIS_HPP
+
+#include "ast.hpp"
+
+#include <string>
+#include <vector>
+
+//////////////////////////////////////
+// Ewolucja skalarów w pętlach (scalar evolution)
+//////////////////////////////////////
+
+// Rodzaj przyrostu akumulatora w jednym obrocie pętli
+enum class AccStep {
+    INVARIANT,        // acc := acc + c          (c niezmienne w pętli)
+    ITERATOR,         // acc := acc + i          (i - iterator FOR)
+    SCALED_ITERATOR,  // acc := acc + c * i
+    SQUARED_ITERATOR  // acc := acc + i * i
+};
+
+// Jedna rekurencja: acc := acc (+|-) krok
+struct AccumulatorRec {
+    Name acc;
+    AccStep step = AccStep::INVARIANT;
+    ASTNode* factor = nullptr; // niezmiennik c (ValueNode / IdentifierNode), jeśli jest
+    bool subtract = false;
+};
+
+// Pętla zastępowalna wzorem zamkniętym
+struct ClosedFormLoop {
+    std::vector<AccumulatorRec> recs;
+
+    // Tylko WHILE: licznik v := v (+|-) 1 i warunek "v op bound"
+    Name counter;
+    long long counterStep = 0;  // +1 / -1
+    ASTNode* bound = nullptr;   // ValueNode / IdentifierNode
+    bool inclusive = false;     // <= / >= (zamiast < / >)
+};
+
+// FOR_UP / FOR_DOWN, w którego ciele są wyłącznie rekurencje akumulatorów
+bool analyzeForLoop(CommandNode &node, ClosedFormLoop &out);
+
+// WHILE z licznikiem o kroku 1 i akumulatorami o niezmiennym przyroście
+bool analyzeWhileLoop(CommandNode &node, ClosedFormLoop &out);
+
+#endif // LOOP_ANALYSIS_HPP
@@ -0,0 +1,225 @@
+#include "loop_fusion.hpp"
+#include "loop_analysis.hpp"
+
+// ------------------ Pomocnicze ------------------
+
+static bool sameExpr(const ASTNode* a, const ASTNode* b) {
+    if (!a || !b) return a == b;
+    if (auto* va = dynamic_cast<const ValueNode*>(a)) {
+        auto* vb = dynamic_cast<const ValueNode*>(b);
+        return vb && va->val == vb->val;
+    }
+    if (auto* ia = dynamic_cast<const IdentifierNode*>(a)) {
+        auto* ib = dynamic_cast<const IdentifierNode*>(b);
+        return ib && ia->name == ib->name && sameExpr(ia->indexExpr, ib->indexExpr);
+    }
+    if (auto* ea = dynamic_cast<const ExpressionNode*>(a)) {
+        auto* eb = dynamic_cast<const ExpressionNode*>(b);
+        return eb && ea->op == eb->op && sameExpr(ea->left, eb->left) && sameExpr(ea->right, eb->right);
+    }
+    return false;
+}
+
+// t[iter]: jedyny indeks, przy którym obrót i obu ciał dotyka tego samego elementu
+static bool indexedByIter(const ASTNode* index, Name iter) {
+    auto* idn = dynamic_cast<const IdentifierNode*>(index);
+    return idn && !idn->indexExpr && idn->name == iter;
+}
+
+// Użycia symbolu from (po indeksie z analizy semantycznej) => symbol to
+static void renameVar(ASTNode* node, const IdentifierNode* from, const IdentifierNode* to) {
+    if (!node) return;
+    if (auto* cmds = dynamic_cast<CommandsNode*>(node)) {
+        for (auto* c : cmds->cmdList) renameVar(c, from, to);
+    } else if (auto* cmd = dynamic_cast<CommandNode*>(node)) {
+        for (auto* c : cmd->children) renameVar(c, from, to);
+    } else if (auto* e = dynamic_cast<ExpressionNode*>(node)) {
+        renameVar(e->left, from, to);
+        renameVar(e->right, from, to);
+    } else if (auto* idn = dynamic_cast<IdentifierNode*>(node)) {
+        if (idn->sym == from->sym) {
+            idn->name = to->name;
+            idn->sym = to->sym;
+        }
+        renameVar(idn->indexExpr, from, to);
+    }
+}
+
+// ------------------ Efekty ciała ------------------
+
+Name LoopFuser::arrayKey(Name name) const {
+    // dwie tablice-parametry mogą być tą samą tablicą wołającego
+    return paramArrays.count(name) ? Name("$param") : name;
+}
+
+void LoopFuser::scan(ASTNode* node, BodyEffects &fx, bool write) {
+    if (!node) return;
+    if (auto* cmds = dynamic_cast<CommandsNode*>(node)) {
+        for (auto* c : cmds->cmdList) scan(c, fx, false);
+        return;
+    }
+    if (auto* cmd = dynamic_cast<CommandNode*>(node)) {
+        switch (cmd->cmdKind) {
+        case CommandKind::ASSIGN:
+            scan(cmd->children[0], fx, true);
+            scan(cmd->children[1], fx, false);
+            break;
+        case CommandKind::READ:
+            fx.io = true;
+            scan(cmd->children[0], fx, true);
+            break;
+        case CommandKind::WRITE:
+            fx.io = true;
+            scan(cmd->children[0], fx, false);
+            break;
+        case CommandKind::PROC_CALL:
+            fx.call = true;
+            break;
+        case CommandKind::FOR_UP:
+        case CommandKind::FOR_DOWN:
+            // iterator zagnieżdżonej pętli jest jej własną zmienną
+            for (size_t i = 1; i < cmd->children.size(); i++) scan(cmd->children[i], fx, false);
+            break;
+        default:
+            for (auto* c : cmd->children) scan(c, fx, false);
+        }
+        return;
+    }
+    if (auto* e = dynamic_cast<ExpressionNode*>(node)) {
+        scan(e->left, fx, false);
+        scan(e->right, fx, false);
+        return;
+    }
+    if (auto* idn = dynamic_cast<IdentifierNode*>(node)) {
+        fx.names.insert(idn->name);
+        if (idn->indexExpr) {
+            fx.arrays.push_back({arrayKey(idn->name), idn->indexExpr, write});
+            if (write) fx.arraysWritten.insert(arrayKey(idn->name));
+            scan(idn->indexExpr, fx, false);
+        } else if (write) {
+            fx.writes.insert(idn->name);
+        } else {
+            fx.reads.insert(idn->name);
+        }
+    }
+}
+
+// ------------------ Legalność ------------------
+
+static bool intersects(const std::set<Name> &a, const std::set<Name> &b) {
+    for (auto &x : a) {
+        if (b.count(x)) return true;
+    }
+    return false;
+}
+
+bool LoopFuser::canFuse(CommandNode* first, CommandNode* second) {
+    if (first->cmdKind != second->cmdKind) return false;
+    if (!sameExpr(first->children[1], second->children[1])
+        || !sameExpr(first->children[2], second->children[2]))
+        return false;
+
+    // Pętla liczona wzorem zamkniętym jest tańsza niż scalona
+    ClosedFormLoop cf;
+    if (analyzeForLoop(*first, cf) || analyzeForLoop(*second, cf)) return false;
+
+    auto* it1 = dynamic_cast<IdentifierNode*>(first->children[0]);
+    auto* it2 = dynamic_cast<IdentifierNode*>(second->children[0]);
+    if (!it1 || !it2) return false;
+    Name iter = it1->name;
+
+    BodyEffects b1, b2;
+    scan(first->children[3], b1, false);
+    scan(second->children[3], b2, false);
+    if (b1.call || b2.call || (b1.io && b2.io)) return false;
+
+    // Zmiana nazwy iteratora drugiej pętli nie może niczego przesłonić
+    if (it2->name != iter && (b2.names.count(iter) || b1.names.count(it2->name))) return false;
+
+    // Granice drugiej pętli liczone po pierwszej => B1 ich nie zmienia
+    BodyEffects bounds;
+    scan(second->children[1], bounds, false);
+    scan(second->children[2], bounds, false);
+    std::set<Name> boundArrays;
+    for (auto &a : bounds.arrays) boundArrays.insert(a.array);
+    if (intersects(b1.writes, bounds.names) || intersects(b1.arraysWritten, boundArrays)) return false;
+
+    // Zwykłe zmienne: B2 widzi końcowe wartości B1, B1 nie widzi zmian B2
+    if (intersects(b1.writes, b2.reads) || intersects(b1.writes, b2.writes)
+        || intersects(b2.writes, b1.reads))
+        return false;
+
+    // Tablice z zapisem: B2 w obrocie i dotyka tylko elementu i, który B1 już
+    // skończyło (indeks to zmienna albo liczba, więc t[i] po obu stronach)
+    for (auto &a1 : b1.arrays) {
+        for (auto &a2 : b2.arrays) {
+            if (a1.array != a2.array || (!a1.write && !a2.write)) continue;
+            if (!indexedByIter(a1.index, iter) || !indexedByIter(a2.index, it2->name)) return false;
+        }
+    }
+    return true;
+}
+
+// ------------------ Przebieg ------------------
+
+void LoopFuser::fuse(CommandNode* first, CommandNode* second) {
+    auto* it1 = static_cast<IdentifierNode*>(first->children[0]);
+    auto* it2 = static_cast<IdentifierNode*>(second->children[0]);
+    renameVar(second->children[3], it2, it1);
+
+    auto* body1 = dynamic_cast<CommandsNode*>(first->children[3]);
+    auto* body2 = dynamic_cast<CommandsNode*>(second->children[3]);
+    body1->cmdList.insert(body1->cmdList.end(), body2->cmdList.begin(), body2->cmdList.end());
+    body2->cmdList.clear();
+    delete second;
+    fused++;
+}
+
+void LoopFuser::fuseCommands(ASTNode* node) {
+    if (auto* cmd = dynamic_cast<CommandNode*>(node)) {
+        for (auto* c : cmd->children) fuseCommands(c);
+        return;
+    }
+    auto* cmds = dynamic_cast<CommandsNode*>(node);
+    if (!cmds) return;
+
+    // najpierw pętle wewnętrzne
+    for (auto* c : cmds->cmdList) fuseCommands(c);
+
+    auto isFor = [](CommandNode* c) {
+        return c && (c->cmdKind == CommandKind::FOR_UP || c->cmdKind == CommandKind::FOR_DOWN)
+            && dynamic_cast<CommandsNode*>(c->children[3]);
+    };
+    for (size_t k = 0; k + 1 < cmds->cmdList.size();) {
+        auto* first = dynamic_cast<CommandNode*>(cmds->cmdList[k]);
+        auto* second = dynamic_cast<CommandNode*>(cmds->cmdList[k + 1]);
+        if (isFor(first) && isFor(second) && canFuse(first, second)) {
+            fuse(first, second);
+            cmds->cmdList.erase(cmds->cmdList.begin() + k + 1);
+            continue; // może da się dołączyć kolejną
+        }
+        k++;
+    }
+}
+
+void LoopFuser::run(ASTNode* root) {
+    auto* program = dynamic_cast<ProgramAllNode*>(root);
+    if (!program) return;
+
+    if (auto* procs = dynamic_cast<ProceduresNode*>(program->procedures)) {
+        for (auto* p : procs->procedureDecls) {
+            auto* pd = dynamic_cast<ProcedureDeclNode*>(p);
+            if (!pd) continue;
+            paramArrays.clear();
+            if (auto* formals = dynamic_cast<ArgsDeclNode*>(pd->argsDecl)) {
+                for (size_t i = 0; i < formals->argNames.size(); i++)
+                    if (formals->isArray[i]) paramArrays.insert(formals->argNames[i]);
+            }
+            fuseCommands(pd->commands);
+        }
+    }
+    if (auto* mn = dynamic_cast<MainNode*>(program->mainPart)) {
+        paramArrays.clear();
+        fuseCommands(mn->commands);
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef LOOP_FUSION_HPP
+#define LOOP_FUSION_HPP
+
+#include "ast.hpp"
+
+#include <set>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////
+// Scalanie sąsiednich pętli FOR o tych samych granicach
+//////////////////////////////////////
+//
+// FOR i FROM a TO b DO B1 ENDFOR FOR j FROM a TO b DO B2 ENDFOR
+//   => FOR i FROM a TO b DO B1 B2[j:=i] ENDFOR
+// gdy kolejność B1(i), B2(i), B1(i+1), ... nie zmienia wyniku: B1 nie rusza
+// granic ani zmiennych B2 (i odwrotnie), co najwyżej jedno z ciał robi
+// wejście/wyjście, brak wywołań, a wspólne tablice (z zapisem) są w obu
+// ciałach indeksowane samym iteratorem.
+class LoopFuser {
+public:
+    void run(ASTNode* root);
+
+    int fused = 0; ///< liczba scalonych par pętli
+
+private:
+    // Dostęp do elementu tablicy
+    struct ArrayAccess {
+        Name array;
+        ASTNode* index;
+        bool write;
+    };
+
+    // Co robi ciało pętli
+    struct BodyEffects {
+        std::set<Name> reads;   // zwykłe zmienne czytane
+        std::set<Name> writes;  // zwykłe zmienne zmieniane
+        std::set<Name> names;   // wszystkie nazwy (także tablice)
+        std::set<Name> arraysWritten;
+        std::vector<ArrayAccess> arrays;
+        bool io = false;
+        bool call = false;
+    };
+
+    std::set<Name> paramArrays; ///< tablice-parametry bieżącej procedury (mogą się pokrywać)
+
+    Name arrayKey(Name name) const;
+    void scan(ASTNode* node, BodyEffects &fx, bool write);
+    bool canFuse(CommandNode* first, CommandNode* second);
+    void fuse(CommandNode* first, CommandNode* second);
+    void fuseCommands(ASTNode* node);
+};
+
+#endif // LOOP_FUSION_HPP
@@ -1,75 +1,65 @@
 #include <iostream>
-#include <fstream>
-#include "ast.hpp"
-#include "semantic_visitor.hpp"
-#include "ast_print.cpp"
-#include "codegen_visitor.hpp"
-
-// Deklaracja parsera:
-int yyparse();
-extern ASTNode* g_root; // globalny wskaźnik do AST
-extern FILE* yyin;
+#include <string>
+#include <vector>
+#include "batch.hpp"
+#include "compiler.hpp"
+#include "options.hpp"
+#include "server.hpp"
 
 int main(int argc, char** argv) {
-    if (argc < 3) {
-        std::cerr << "Użycie: " << argv[0] << " <plik_zrodlowy> <plik_wyjsciowy>\n";
-        return 1;
+    // Opcje "--..." mogą stać przed plikami
+    CompileOptions opts;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) == 0) {
+            if (!opts.parse(arg)) {
+                std::cerr << "Nieznana opcja " << arg << "\n";
+                return 1;
+            }
+        } else {
+            files.push_back(arg);
+        }
     }
-    
-    // Otwieramy plik wejściowy
-    FILE* f = fopen(argv[1], "r");
-    if (!f) {
-        std::cerr << "Nie można otworzyć pliku " << argv[1] << "\n";
-        return 2;
+    if (!opts.server.empty()) {
+        return runServer(opts.server, opts);
     }
-    yyin = f;
-    
-    // Parsowanie
-    int parseRes = yyparse();
-    fclose(f);
-    
-    if (parseRes != 0) {
-        std::cerr << "Błąd parsowania!\n";
-        return 3;
+    if (!opts.connect.empty() && opts.stopServer) {
+        return stopServer(opts.connect);
     }
-    if (!g_root) {
-        std::cerr << "AST nie powstało\n";
-        return 4;
+    if (!opts.batch.empty() && files.empty()) {
+        return compileBatch(opts.batch, opts);
     }
-    
-    // Wypisujemy AST (opcjonalnie)
-    // printAST(g_root);
-    
-    std::cout << "Parsowanie OK. Teraz analiza semantyczna...\n";
-    
-    // Analiza semantyczna
-    SemanticVisitor visitor;
-    visitor.analyze(g_root);
-    
-    if (visitor.symTab.errors > 0) {
-        std::cerr << "Wykryto " << visitor.symTab.errors 
-                  << " błędów semantycznych.\n";
-        return 5;
+    if (files.size() < 2) {
+        std::cerr << "Użycie: " << argv[0] << " [opcje] <plik_zrodlowy> <plik_wyjsciowy>\n"
+                  << "       " << argv[0] << " [opcje] --batch=KATALOG|MANIFEST\n"
+                  << "  --pe-budget=N  limit kroków ewaluacji w czasie kompilacji (domyślnie "
+                  << opts.peStepBudget << ")\n"
+                  << "  --no-pe        bez ewaluacji w czasie kompilacji\n"
+                  << "  --clone-budget=N  limit rozmiaru klonów procedur (domyślnie "
+                  << opts.cloneBudget << ", 0 => wyłączone)\n"
+                  << "  --no-fold      bez scalania identycznego kodu\n"
+                  << "  --no-dse       bez usuwania martwych przypisań\n"
+                  << "  --no-sra       bez zamiany tablic o stałych indeksach na zmienne\n"
+                  << "  --no-fusion    bez scalania sąsiednich pętli FOR\n"
+                  << "  --check-bounds kontrola zakresu indeksów (poza zakresem: wypisz indeks, HALT)\n"
+                  << "  --profile-gen  kod z licznikami bloków (wypisywane przed HALT)\n"
+                  << "  --profile-use=PLIK  optymalizacja według wyjścia kodu z --profile-gen\n"
+                  << "  --jobs=N       wątki generacji kodu procedur (domyślnie 0 => liczba rdzeni)\n"
+                  << "  --batch=ŚCIEŻKA  kompiluj wszystkie *.imp z katalogu (wynik .mr) albo pary\n"
+                  << "                 \"źródło [wynik]\" z manifestu; --jobs=N to wtedy wątki puli plików\n"
+                  << "  --server=GNIAZDO  serwer kompilacji z pamięcią podręczną wyników\n"
+                  << "  --connect=GNIAZDO kompiluj przez serwer (bez serwera: lokalnie)\n"
+                  << "  --stop-server  z --connect: zatrzymaj serwer\n"
+                  << "  --flex-lexer   czytaj źródło skanerem Flexa zamiast skanera bufora\n";
+        return 1;
     }
     
-    std::cout << "Analiza semantyczna OK. Możemy generować kod.\n";
-    
-    // Generacja kodu
-    SymbolTable& symTab = visitor.symTab;
-    CodeGenVisitor codeGen(symTab);
-    g_root->accept(codeGen);
-    std::string finalCode = codeGen.getCode();
-    
-    // Zapisujemy kod do pliku wyjściowego (podanego jako argv[2])
-    std::ofstream outFile(argv[2]);
-    if (outFile.is_open()) {
-        outFile << finalCode;
-        outFile.close();
-        std::cout << "Kod został zapisany do " << argv[2] << std::endl;
-    } else {
-        std::cerr << "Błąd: Nie można otworzyć pliku do zapisu." << std::endl;
-        return 6;
+    if (!opts.connect.empty()) {
+        bool reached = false;
+        int res = compileViaServer(opts.connect, files[0], files[1], opts, reached);
+        if (reached) return res;
+        std::cerr << "Brak serwera na " << opts.connect << ", kompilacja lokalna\n";
     }
-    
-    return 0;
+    return compileProgram(files[0], files[1], opts);
 }
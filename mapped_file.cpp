@@ -0,0 +1,57 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile() {
+    if (addr) munmap((void*)addr, length);
+}
+
+// Do końca pliku; false => błąd odczytu
+static bool readAll(int fd, std::string &out) {
+    char buf[65536];
+    ssize_t n;
+    while ((n = ::read(fd, buf, sizeof(buf))) > 0) out.append(buf, (size_t)n);
+    return n == 0;
+}
+
+bool MappedFile::open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        // potok itp.: czytamy do końca
+        bool ok = readAll(fd, copy);
+        close(fd);
+        return ok;
+    }
+    length = (size_t)st.st_size;
+    if (length > 0) {
+        void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            length = 0;
+            return false;
+        }
+        madvise(p, length, MADV_SEQUENTIAL); // lekser czyta raz, od początku do końca
+        addr = (const char*)p;
+    }
+    close(fd); // mapowanie zostaje ważne po zamknięciu deskryptora
+    return true;
+}
+
+bool MappedFile::read(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) copy.reserve((size_t)st.st_size);
+    bool ok = readAll(fd, copy);
+    close(fd);
+    return ok;
+}
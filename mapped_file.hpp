@@ -0,0 +1,36 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+//////////////////////////////////////
+// Plik zmapowany do pamięci (tylko do odczytu)
+//////////////////////////////////////
+//
+// Źródło czytane wprost ze stron pliku, bez kopiowania przez bufory stdio.
+// Czego nie da się zmapować (potok, /dev/stdin), jest wczytywane do bufora.
+// read() zawsze czyta do bufora: plik skrócony w trakcie kompilacji daje
+// wtedy starą treść, a nie SIGBUS przy dostępie do strony za nowym końcem.
+// Pusty plik => data() wskazuje na pusty napis, size() == 0.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const std::string &path); ///< false => brak pliku / błąd mapowania
+    bool read(const std::string &path); ///< jak open, ale kopia zamiast mapowania
+
+    const char* data() const { return addr ? addr : copy.c_str(); }
+    size_t size() const { return addr ? length : copy.size(); }
+
+private:
+    const char* addr = nullptr; ///< mapowanie (nullptr => treść w copy)
+    size_t length = 0;
+    std::string copy;
+};
+
+#endif // MAPPED_FILE_HPP
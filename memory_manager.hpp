@@ -19,7 +19,7 @@ public:
     }
 
 
-    long long getNextAddress() {
+    long long getNextAddress() const {
         return nextOffset;
     }
 
@@ -0,0 +1,139 @@
+#ifndef OPTIONS_HPP
+#define OPTIONS_HPP
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+//////////////////////////////////////
+// Opcje kompilacji (przełączniki z linii poleceń)
+//////////////////////////////////////
+struct CompileOptions {
+    // Limit kroków ewaluatora czasu kompilacji (0 => wyłączony)
+    long long peStepBudget = 1000000;
+
+    // Limit rozmiaru klonów procedur specjalizowanych stałymi (węzły AST, 0 => bez klonowania)
+    long long cloneBudget = 1000;
+
+    // Scalanie identycznych procedur i końcówek po generacji kodu
+    bool foldCode = true;
+
+    // Usuwanie martwych przypisań (AST) i zapisów do komórek roboczych (kod)
+    bool deadStores = true;
+
+    // Tablice indeksowane tylko stałymi => osobne zmienne
+    bool scalarReplace = true;
+
+    // Scalanie sąsiednich pętli FOR o tych samych granicach
+    bool loopFusion = true;
+
+    // Kontrola zakresu indeksów tablic w czasie wykonania (wersje testowe)
+    bool checkBounds = false;
+
+    // Profil: kod z licznikami bloków / plik z wyjściem takiego kodu ("" => brak)
+    bool profileGen = false;
+    std::string profileUse;
+
+    // Wątki generacji kodu procedur, w trybie wsadowym wątki puli plików (0 => liczba rdzeni)
+    unsigned jobs = 0;
+
+    // Tryb wsadowy: katalog z *.imp albo manifest "źródło [wynik]" ("" => jeden plik)
+    std::string batch;
+
+    // Serwer kompilacji: gniazdo, na którym nasłuchuje (--server) / do którego
+    // klient przekazuje kompilację (--connect); "" => bez serwera
+    std::string server;
+    std::string connect;
+    bool stopServer = false; ///< z --connect: zatrzymaj serwer zamiast kompilować
+
+    // Źródło czytane skanerem Flexa (lexer.l) zamiast skanera bufora; ten sam kod
+    bool flexLexer = false;
+
+    // Rozpoznaje jedną opcję "--nazwa[=wartość]"; false => nieznana opcja
+    bool parse(const std::string &arg) {
+        if (arg.rfind("--pe-budget=", 0) == 0) {
+            peStepBudget = std::atoll(arg.c_str() + 12);
+            return true;
+        }
+        if (arg.rfind("--clone-budget=", 0) == 0) {
+            cloneBudget = std::atoll(arg.c_str() + 15);
+            return true;
+        }
+        if (arg == "--no-dse") {
+            deadStores = false;
+            return true;
+        }
+        if (arg == "--no-sra") {
+            scalarReplace = false;
+            return true;
+        }
+        if (arg == "--no-fusion") {
+            loopFusion = false;
+            return true;
+        }
+        if (arg == "--no-fold") {
+            foldCode = false;
+            return true;
+        }
+        if (arg == "--check-bounds") {
+            checkBounds = true;
+            return true;
+        }
+        if (arg == "--profile-gen") {
+            profileGen = true;
+            return true;
+        }
+        if (arg.rfind("--profile-use=", 0) == 0) {
+            profileUse = arg.substr(14);
+            return true;
+        }
+        if (arg.rfind("--jobs=", 0) == 0) {
+            jobs = (unsigned)std::atoi(arg.c_str() + 7);
+            return true;
+        }
+        if (arg.rfind("--batch=", 0) == 0) {
+            batch = arg.substr(8);
+            return true;
+        }
+        if (arg.rfind("--server=", 0) == 0) {
+            server = arg.substr(9);
+            return true;
+        }
+        if (arg.rfind("--connect=", 0) == 0) {
+            connect = arg.substr(10);
+            return true;
+        }
+        if (arg == "--stop-server") {
+            stopServer = true;
+            return true;
+        }
+        if (arg == "--flex-lexer") {
+            flexLexer = true;
+            return true;
+        }
+        if (arg == "--no-pe") {
+            peStepBudget = 0;
+            return true;
+        }
+        return false;
+    }
+
+    // Opcje wpływające na wygenerowany kod, w postaci dla parse(): ta sama
+    // lista dla tych samych ustawień (klucz pamięci podręcznej serwera,
+    // przekazanie opcji klient => serwer). Bez jobs/batch/server/connect/flex-lexer.
+    std::vector<std::string> codeArgs() const {
+        std::vector<std::string> args;
+        args.push_back("--pe-budget=" + std::to_string(peStepBudget));
+        args.push_back("--clone-budget=" + std::to_string(cloneBudget));
+        if (!foldCode) args.push_back("--no-fold");
+        if (!deadStores) args.push_back("--no-dse");
+        if (!scalarReplace) args.push_back("--no-sra");
+        if (!loopFusion) args.push_back("--no-fusion");
+        if (checkBounds) args.push_back("--check-bounds");
+        if (profileGen) args.push_back("--profile-gen");
+        if (!profileUse.empty()) args.push_back("--profile-use=" + profileUse);
+        return args;
+    }
+};
+
+#endif // OPTIONS_HPP
@@ -0,0 +1,31 @@
+#ifndef PARSE_CONTEXT_HPP
+#define PARSE_CONTEXT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+
+class ASTNode;
+class SourceScanner;
+
+//////////////////////////////////////
+// Stan jednego parsowania (parser czysty, lekser wielobieżny)
+//////////////////////////////////////
+//
+// Zamiast globalnych g_root / yyin / lines: każde parsowanie ma własny
+// kontekst i własny skaner, więc wiele kompilacji może iść równolegle.
+struct ParseContext {
+    ASTNode* root = nullptr; ///< korzeń drzewa (ustawia reguła program_all)
+    uint64_t line = 1;       ///< bieżąca linia źródła (lekser)
+    std::ostream* diag = &std::cerr; ///< komunikaty o błędach składni
+    SourceScanner* source = nullptr; ///< skaner bufora (parseBuffer), inaczej Flex
+};
+
+// Parsuje cały plik; wynik jak yyparse (0 => OK), drzewo w ctx.root
+int parseProgram(FILE* in, ParseContext &ctx);
+
+// Parsuje źródło z pamięci skanerem bufora (bez Flexa); wynik jak parseProgram
+int parseBuffer(const char* data, size_t size, ParseContext &ctx);
+
+#endif // PARSE_CONTEXT_HPP
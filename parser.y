@@ -5,15 +5,7 @@
 #include <string>
 
 #include "ast.hpp"
-
-// Deklaracja funkcji do obsługi błędów i skanera:
-static void yyerror(const char* msg);
-int yylex(void);
-
-// Globalny wskaźnik do korzenia AST:
-ASTNode* g_root = nullptr;
-
-extern FILE *yyin;
+#include "parse_context.hpp"
 %}
 
 %code requires
@@ -22,12 +14,14 @@ extern FILE *yyin;
     #include <cstdint>
     #include "ast.hpp"
 
+    struct ParseContext;
+    typedef void* yyscan_t; // skaner Flexa (reentrant)
     
-    // Informacje o tokenie: wartość liczbową, numer linii i ewentualny string
+    // Informacje o tokenie: wartość liczbową, numer linii i ewentualny identyfikator
     typedef struct Parser_token {
         uint64_t value;
         uint64_t line;
-        std::string* str;
+        uint32_t sym; // identyfikator: numer w tablicy nazw (StringTable)
     } Parser_token;
 }
 
@@ -38,6 +32,16 @@ extern FILE *yyin;
 }
 
 %locations
+%define api.pure full
+%lex-param {yyscan_t scanner} {ParseContext &ctx}
+%parse-param {yyscan_t scanner} {ParseContext &ctx}
+
+%code
+{
+    // Deklaracja funkcji do obsługi błędów i skanera (source_scanner.cpp):
+    int yylex(YYSTYPE* lvalp, YYLTYPE* llocp, yyscan_t scanner, ParseContext &ctx);
+    static void yyerror(YYLTYPE* llocp, yyscan_t scanner, ParseContext &ctx, const char* msg);
+}
 
 %token YY_SEMICOLON YY_COMMA
 %token YY_ADD YY_SUB YY_MUL YY_DIV YY_MOD
@@ -87,13 +91,13 @@ program_all:
       procedures main
         {
           ProgramAllNode* pan = new ProgramAllNode(@1.first_line, $1, $2);
-          g_root = pan;
+          ctx.root = pan;
           $$ = pan;
         }
     | main
         {
           ProgramAllNode* pan = new ProgramAllNode(@1.first_line, nullptr, $1);
-          g_root = pan;
+          ctx.root = pan;
           $$ = pan;
         }
     ;
@@ -161,10 +165,9 @@ proc_head:
     {
       ProcHeadNode* ph = new ProcHeadNode(
           $1.line,
-          *($1.str),  // nazwa
+          Name::fromIndex($1.sym),  // nazwa
           $3          // wskaźnik do args_decl
       );
-      delete $1.str;
       $$ = ph;
     }
     ;
@@ -193,9 +196,8 @@ declarations:
       declarations YY_COMMA YY_VARIABLE
         {
           DeclarationsNode* dn = dynamic_cast<DeclarationsNode*>($1);
-          DeclarationVarNode* dv = new DeclarationVarNode($3.line, *($3.str));
+          DeclarationVarNode* dv = new DeclarationVarNode($3.line, Name::fromIndex($3.sym));
           dn->declList.push_back(dv);
-          delete $3.str;
           $$ = dn;
         }
     | declarations YY_COMMA YY_VARIABLE YY_L_BRACKET_S YY_NUM YY_ARR_RANGE YY_NUM YY_R_BRACKET_S
@@ -203,20 +205,18 @@ declarations:
           DeclarationsNode* dn = dynamic_cast<DeclarationsNode*>($1);
           DeclarationArrNode* da = new DeclarationArrNode(
               $3.line,
-              *($3.str),
+              Name::fromIndex($3.sym),
               (long long)$5.value,
               (long long)$7.value
           );
           dn->declList.push_back(da);
-          delete $3.str;
           $$ = dn;
         }
     | YY_VARIABLE
         {
           DeclarationsNode* dn = new DeclarationsNode($1.line);
-          DeclarationVarNode* dv = new DeclarationVarNode($1.line, *($1.str));
+          DeclarationVarNode* dv = new DeclarationVarNode($1.line, Name::fromIndex($1.sym));
           dn->declList.push_back(dv);
-          delete $1.str;
           $$ = dn;
         }
     | YY_VARIABLE YY_L_BRACKET_S YY_NUM YY_ARR_RANGE YY_NUM YY_R_BRACKET_S
@@ -224,12 +224,11 @@ declarations:
           DeclarationsNode* dn = new DeclarationsNode($1.line);
           DeclarationArrNode* da = new DeclarationArrNode(
               $1.line,
-              *($1.str),
+              Name::fromIndex($1.sym),
               (long long)$3.value,
               (long long)$5.value
           );
           dn->declList.push_back(da);
-          delete $1.str;
           $$ = dn;
         }
     ;
@@ -241,33 +240,29 @@ args_decl:
       args_decl YY_COMMA YY_VARIABLE
         {
           ArgsDeclNode* ad = dynamic_cast<ArgsDeclNode*>($1);
-          ad->argNames.push_back(*($3.str));
+          ad->argNames.push_back(Name::fromIndex($3.sym));
           ad->isArray.push_back(false);
-          delete $3.str;
           $$ = ad;
         }
     | args_decl YY_COMMA YY_T YY_VARIABLE
         {
           ArgsDeclNode* ad = dynamic_cast<ArgsDeclNode*>($1);
-          ad->argNames.push_back(*($4.str));
+          ad->argNames.push_back(Name::fromIndex($4.sym));
           ad->isArray.push_back(true);
-          delete $4.str;
           $$ = ad;
         }
     | YY_VARIABLE
         {
           ArgsDeclNode* ad = new ArgsDeclNode($1.line);
-          ad->argNames.push_back(*($1.str));
+          ad->argNames.push_back(Name::fromIndex($1.sym));
           ad->isArray.push_back(false);
-          delete $1.str;
           $$ = ad;
         }
     | YY_T YY_VARIABLE
         {
           ArgsDeclNode* ad = new ArgsDeclNode($1.line);
-          ad->argNames.push_back(*($2.str));
+          ad->argNames.push_back(Name::fromIndex($2.sym));
           ad->isArray.push_back(true);
-          delete $2.str;
           $$ = ad;
         }
     ;
@@ -279,15 +274,13 @@ args:
       args YY_COMMA YY_VARIABLE
         {
           ArgsNode* an = dynamic_cast<ArgsNode*>($1);
-          an->varNames.push_back(*($3.str));
-          delete $3.str;
+          an->varNames.push_back(Name::fromIndex($3.sym));
           $$ = an;
         }
     | YY_VARIABLE
         {
           ArgsNode* an = new ArgsNode($1.line);
-          an->varNames.push_back(*($1.str));
-          delete $1.str;
+          an->varNames.push_back(Name::fromIndex($1.sym));
           $$ = an;
         }
     ;
@@ -356,23 +349,21 @@ command:
     | YY_FOR YY_VARIABLE YY_FROM value YY_TO value YY_DO commands YY_ENDFOR
         {
           CommandNode* cmd = new CommandNode($1.line, CommandKind::FOR_UP);
-          IdentifierNode* iter = new IdentifierNode($2.line, *($2.str), nullptr);
+          IdentifierNode* iter = new IdentifierNode($2.line, Name::fromIndex($2.sym), nullptr);
           cmd->children.push_back(iter); // iterator
           cmd->children.push_back($4);   // from
           cmd->children.push_back($6);   // to
           cmd->children.push_back($8);   // body
-          delete $2.str;
           $$ = cmd;
         }
     | YY_FOR YY_VARIABLE YY_FROM value YY_DOWNTO value YY_DO commands YY_ENDFOR
         {
           CommandNode* cmd = new CommandNode($1.line, CommandKind::FOR_DOWN);
-          IdentifierNode* iter = new IdentifierNode($2.line, *($2.str), nullptr);
+          IdentifierNode* iter = new IdentifierNode($2.line, Name::fromIndex($2.sym), nullptr);
           cmd->children.push_back(iter);
           cmd->children.push_back($4);   // from
           cmd->children.push_back($6);   // downto
           cmd->children.push_back($8);   // body
-          delete $2.str;
           $$ = cmd;
         }
     | proc_call YY_SEMICOLON
@@ -400,8 +391,7 @@ proc_call:
     YY_VARIABLE YY_L_BRACKET_R args YY_R_BRACKET_R
     {
       // Załóżmy, że ProcCallNode ma konstruktor (line, nazwa, wskaźnik do args):
-      ProcCallNode* call = new ProcCallNode($1.line, *($1.str), $3);
-      delete $1.str;
+      ProcCallNode* call = new ProcCallNode($1.line, Name::fromIndex($1.sym), $3);
       $$ = call;
     }
     ;
@@ -503,31 +493,28 @@ number:
 identifier:
       YY_VARIABLE
         {
-          IdentifierNode* idn = new IdentifierNode($1.line, *($1.str), nullptr);
-          delete $1.str;
+          IdentifierNode* idn = new IdentifierNode($1.line, Name::fromIndex($1.sym), nullptr);
           $$ = idn;
         }
     | YY_VARIABLE YY_L_BRACKET_S YY_VARIABLE YY_R_BRACKET_S
         {
           // index = kolejny identifier
-          IdentifierNode* idx = new IdentifierNode($3.line, *($3.str), nullptr);
-          IdentifierNode* idn = new IdentifierNode($1.line, *($1.str), idx);
-          delete $1.str; delete $3.str;
+          IdentifierNode* idx = new IdentifierNode($3.line, Name::fromIndex($3.sym), nullptr);
+          IdentifierNode* idn = new IdentifierNode($1.line, Name::fromIndex($1.sym), idx);
           $$ = idn;
         }
     | YY_VARIABLE YY_L_BRACKET_S YY_NUM YY_R_BRACKET_S
         {
           // index = ValueNode
           ValueNode* vn = new ValueNode($3.line, (long long)$3.value);
-          IdentifierNode* idn = new IdentifierNode($1.line, *($1.str), vn);
-          delete $1.str;
+          IdentifierNode* idn = new IdentifierNode($1.line, Name::fromIndex($1.sym), vn);
           $$ = idn;
         }
     ;
 
 %%
 
-static void yyerror(const char* msg)
+static void yyerror(YYLTYPE* llocp, yyscan_t scanner, ParseContext &ctx, const char* msg)
 {
-    std::cerr << "Parse error: " << msg << std::endl;
+    *ctx.diag << "Parse error: " << msg << std::endl;
 }
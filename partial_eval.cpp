@@ -0,0 +1,382 @@
+#include "partial_eval.hpp"
+#include "ast_opt.hpp"
+#include <iostream>
+
+// ------------------ Start ------------------
+
+void PartialEvaluator::run(ASTNode* root) {
+    if (!root || stepBudget <= 0) return;
+    root->accept(*this);
+}
+
+bool PartialEvaluator::tick() {
+    if (++steps > stepBudget) stop();
+    return !stopped;
+}
+
+// ------------------ Pamięć ------------------
+
+SymbolInfo* PartialEvaluator::resolveArray(SymbolInfo* si) {
+    // T-parametr wskazuje na tablicę przekazaną w wywołaniu
+    while (si && si->ifParam) {
+        auto it = arrayBindings.find(si);
+        if (it == arrayBindings.end()) return nullptr;
+        si = it->second;
+    }
+    return si;
+}
+
+bool PartialEvaluator::readCell(IdentifierNode &idn, long long &out) {
+    if (!idn.indexExpr) {
+        auto itIt = iterators.find(idn.name);
+        if (itIt != iterators.end()) {
+            out = itIt->second;
+            return true;
+        }
+        SymbolInfo* si = symTab.resolve(idn.sym, idn.name, currentProcedure);
+        auto it = scalars.find(si);
+        if (it == scalars.end()) return false; // wartość nieznana
+        out = it->second;
+        return true;
+    }
+
+    idn.indexExpr->accept(*this);
+    if (stopped) return false;
+    long long index = value;
+    SymbolInfo* arr = resolveArray(symTab.resolve(idn.sym, idn.name, currentProcedure));
+    if (!arr) return false;
+    auto itArr = arrays.find(arr);
+    if (itArr == arrays.end()) return false;
+    auto itEl = itArr->second.find(index);
+    if (itEl == itArr->second.end()) return false;
+    out = itEl->second;
+    return true;
+}
+
+void PartialEvaluator::writeCell(IdentifierNode &idn, long long v) {
+    if (!idn.indexExpr) {
+        auto itIt = iterators.find(idn.name);
+        if (itIt != iterators.end()) {
+            itIt->second = v;
+            return;
+        }
+        writeScalar(symTab.resolve(idn.sym, idn.name, currentProcedure), v);
+        return;
+    }
+
+    idn.indexExpr->accept(*this);
+    if (stopped) return;
+    long long index = value;
+    SymbolInfo* arr = resolveArray(symTab.resolve(idn.sym, idn.name, currentProcedure));
+    // zapis poza zakres nadpisałby sąsiednie komórki - tego nie modelujemy
+    if (!arr || index < arr->lowerBound || index > arr->upperBound) {
+        stop();
+        return;
+    }
+    writeElement(arr, index, v);
+}
+
+void PartialEvaluator::writeScalar(SymbolInfo* si, long long v) {
+    auto it = scalars.find(si);
+    undoLog.push_back({si, false, 0, it != scalars.end(),
+                       it != scalars.end() ? it->second : 0});
+    scalars[si] = v;
+}
+
+void PartialEvaluator::writeElement(SymbolInfo* arr, long long index, long long v) {
+    auto &cells = arrays[arr];
+    auto it = cells.find(index);
+    undoLog.push_back({arr, true, index, it != cells.end(),
+                       it != cells.end() ? it->second : 0});
+    cells[index] = v;
+}
+
+void PartialEvaluator::rollback() {
+    // Cofamy zapisy przerwanej komendy main (od końca)
+    for (auto it = undoLog.rbegin(); it != undoLog.rend(); ++it) {
+        if (it->isArray) {
+            auto &cells = arrays[it->sym];
+            if (it->existed) cells[it->index] = it->oldValue;
+            else cells.erase(it->index);
+        } else {
+            if (it->existed) scalars[it->sym] = it->oldValue;
+            else scalars.erase(it->sym);
+        }
+    }
+    undoLog.clear();
+}
+
+// ------------------ Żywotność po prefiksie ------------------
+
+void PartialEvaluator::collectLive(ASTNode* node, Name owner,
+                                   std::unordered_set<Name> &visitedProcs) {
+    if (!node) return;
+
+    if (auto* cmds = dynamic_cast<CommandsNode*>(node)) {
+        for (auto* c : cmds->cmdList) collectLive(c, owner, visitedProcs);
+    }
+    else if (auto* cmd = dynamic_cast<CommandNode*>(node)) {
+        for (auto* c : cmd->children) collectLive(c, owner, visitedProcs);
+    }
+    else if (auto* expr = dynamic_cast<ExpressionNode*>(node)) {
+        collectLive(expr->left, owner, visitedProcs);
+        collectLive(expr->right, owner, visitedProcs);
+    }
+    else if (auto* idn = dynamic_cast<IdentifierNode*>(node)) {
+        SymbolInfo* si = symTab.resolve(idn->sym, idn->name, owner);
+        if (si) liveSymbols.insert(si);
+        collectLive(idn->indexExpr, owner, visitedProcs);
+    }
+    else if (auto* pc = dynamic_cast<ProcCallNode*>(node)) {
+        if (auto* an = dynamic_cast<ArgsNode*>(pc->args)) {
+            for (auto &nm : an->varNames) {
+                SymbolInfo* si = symTab.lookup(nm, owner);
+                if (si) liveSymbols.insert(si);
+            }
+        }
+        if (visitedProcs.insert(pc->procName).second) {
+            // zmienne procedury są statyczne => wszystkie jej komórki mogą zostać odczytane
+            for (auto &entry : symTab.localScopes[pc->procName]) {
+                liveSymbols.insert(&symTab.at(entry.second));
+            }
+            auto it = procs.find(pc->procName);
+            if (it != procs.end()) {
+                collectLive(it->second->commands, pc->procName, visitedProcs);
+            }
+        }
+    }
+}
+
+// ------------------ Wizytory AST ------------------
+
+void PartialEvaluator::visit(ProgramAllNode &node) {
+    if (auto* ps = dynamic_cast<ProceduresNode*>(node.procedures)) {
+        for (auto* p : ps->procedureDecls) {
+            auto* pd = dynamic_cast<ProcedureDeclNode*>(p);
+            if (pd) procs[pd->procName] = pd;
+        }
+    }
+    if (node.mainPart) node.mainPart->accept(*this);
+}
+
+void PartialEvaluator::visit(ProceduresNode &node) {}
+void PartialEvaluator::visit(ProcHeadNode &node) {}
+void PartialEvaluator::visit(ProcedureDeclNode &node) {}
+
+void PartialEvaluator::visit(MainNode &node) {
+    auto* cmds = dynamic_cast<CommandsNode*>(node.commands);
+    if (!cmds) return;
+
+    currentProcedure = "";
+    for (auto* c : cmds->cmdList) {
+        // Każdą komendę main liczymy w całości albo wcale
+        undoLog.clear();
+        size_t outMark = outputs.size();
+        iterators.clear();
+        c->accept(*this);
+        if (stopped) {
+            rollback();
+            outputs.resize(outMark);
+            break;
+        }
+        consumed++;
+    }
+    undoLog.clear();
+    iterators.clear();
+
+    std::unordered_set<Name> visitedProcs;
+    for (size_t i = consumed; i < cmds->cmdList.size(); i++) {
+        collectLive(cmds->cmdList[i], "", visitedProcs);
+    }
+}
+
+void PartialEvaluator::visit(DeclarationsNode &node) {}
+void PartialEvaluator::visit(DeclarationVarNode &node) {}
+void PartialEvaluator::visit(DeclarationArrNode &node) {}
+
+void PartialEvaluator::visit(CommandsNode &node) {
+    for (auto* c : node.cmdList) {
+        if (stopped) return;
+        c->accept(*this);
+    }
+}
+
+void PartialEvaluator::visit(CommandNode &node) {
+    if (stopped || !tick()) return;
+
+    switch (node.cmdKind) {
+
+    case CommandKind::ASSIGN: {
+        node.children[1]->accept(*this);
+        if (stopped) return;
+        auto* idn = dynamic_cast<IdentifierNode*>(node.children[0]);
+        writeCell(*idn, value);
+        break;
+    }
+
+    case CommandKind::IF_THEN: {
+        node.children[0]->accept(*this);
+        if (stopped) return;
+        if (value != 0) node.children[1]->accept(*this);
+        break;
+    }
+
+    case CommandKind::IF_THEN_ELSE: {
+        node.children[0]->accept(*this);
+        if (stopped) return;
+        if (value != 0) node.children[1]->accept(*this);
+        else            node.children[2]->accept(*this);
+        break;
+    }
+
+    case CommandKind::WHILE: {
+        while (true) {
+            node.children[0]->accept(*this);
+            if (stopped || value == 0) return;
+            node.children[1]->accept(*this);
+            if (stopped || !tick()) return;
+        }
+    }
+
+    case CommandKind::REPEAT_UNTIL: {
+        while (true) {
+            node.children[0]->accept(*this);
+            if (stopped) return;
+            node.children[1]->accept(*this);
+            if (stopped || value != 0) return;
+            if (!tick()) return;
+        }
+    }
+
+    case CommandKind::FOR_UP:
+    case CommandKind::FOR_DOWN: {
+        // [0]=iter, [1]=from, [2]=to, [3]=body; liczba obrotów ustalona na starcie
+        auto* idn = dynamic_cast<IdentifierNode*>(node.children[0]);
+        node.children[1]->accept(*this);
+        if (stopped) return;
+        long long from = value;
+        node.children[2]->accept(*this);
+        if (stopped) return;
+        long long to = value;
+
+        bool up = (node.cmdKind == CommandKind::FOR_UP);
+        // skrajne granice => liczba obrotów poza long long, dalej już w czasie wykonania
+        long long count;
+        if (up ? __builtin_sub_overflow(to, from, &count) : __builtin_sub_overflow(from, to, &count)) {
+            stop();
+            return;
+        }
+        if (__builtin_add_overflow(count, 1LL, &count)) {
+            stop();
+            return;
+        }
+        for (long long k = 0; k < count; k++) {
+            iterators[idn->name] = up ? from + k : from - k;
+            node.children[3]->accept(*this);
+            if (stopped || !tick()) return;
+        }
+        iterators.erase(idn->name);
+        break;
+    }
+
+    case CommandKind::PROC_CALL: {
+        node.children[0]->accept(*this);
+        break;
+    }
+
+    case CommandKind::READ: {
+        // Od tego miejsca program zależy od wejścia
+        stop();
+        break;
+    }
+
+    case CommandKind::WRITE: {
+        node.children[0]->accept(*this);
+        if (stopped) return;
+        outputs.push_back(value);
+        break;
+    }
+
+    default:
+        stop();
+    }
+}
+
+void PartialEvaluator::visit(ArgsDeclNode &node) {}
+void PartialEvaluator::visit(ArgsNode &node) {}
+
+void PartialEvaluator::visit(ProcCallNode &node) {
+    auto itProc = procs.find(node.procName);
+    if (itProc == procs.end()) {
+        stop();
+        return;
+    }
+    ProcedureDeclNode* pd = itProc->second;
+    auto* formals = dynamic_cast<ArgsDeclNode*>(pd->argsDecl);
+    auto* actuals = dynamic_cast<ArgsNode*>(node.args);
+    size_t argsSize = formals ? formals->argNames.size() : 0;
+
+    // Copy-in (zmienne) / wiązanie wskaźnika (tablice) - jak w CodeGenVisitor
+    std::vector<SymbolInfo*> formalSyms(argsSize);
+    for (size_t i = 0; i < argsSize; i++) {
+        formalSyms[i] = symTab.lookupOwned(formals->argNames[i], pd->procName);
+        if (formals->isArray[i]) {
+            SymbolInfo* arr = resolveArray(symTab.lookup(actuals->varNames[i], currentProcedure));
+            if (!arr) {
+                stop();
+                return;
+            }
+            arrayBindings[formalSyms[i]] = arr;
+        } else {
+            IdentifierNode arg(node.getLine(), actuals->varNames[i], nullptr);
+            long long v;
+            if (!readCell(arg, v)) {
+                stop();
+                return;
+            }
+            writeScalar(formalSyms[i], v);
+        }
+    }
+
+    Name oldProc = currentProcedure;
+    std::unordered_map<Name, long long> oldIterators;
+    oldIterators.swap(iterators);
+    currentProcedure = pd->procName;
+
+    if (pd->commands) pd->commands->accept(*this);
+
+    currentProcedure = oldProc;
+    iterators.swap(oldIterators);
+    if (stopped) return;
+
+    // Copy-back zmiennych, w kolejności argumentów
+    for (size_t i = 0; i < argsSize; i++) {
+        if (formals->isArray[i]) continue;
+        IdentifierNode arg(node.getLine(), actuals->varNames[i], nullptr);
+        writeCell(arg, scalars[formalSyms[i]]);
+    }
+}
+
+void PartialEvaluator::visit(ExpressionNode &node) {
+    node.left->accept(*this);
+    if (stopped) return;
+    long long a = value;
+    node.right->accept(*this);
+    if (stopped) return;
+    long long b = value;
+
+    long long r = 0;
+    if (!evalBinary(node.op, a, b, r)) {
+        stop();
+        return;
+    }
+    value = r;
+}
+
+void PartialEvaluator::visit(ValueNode &node) {
+    value = node.val;
+}
+
+void PartialEvaluator::visit(IdentifierNode &node) {
+    if (!readCell(node, value)) stop();
+}
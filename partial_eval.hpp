@@ -0,0 +1,88 @@
+#ifndef PARTIAL_EVAL_HPP
+#define PARTIAL_EVAL_HPP
+
+#include "ast.hpp"
+#include "symtable.hpp"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <map>
+
+// Ewaluator czasu kompilacji: wykonuje początkowe komendy main, dopóki nie
+// zależą od wejścia (READ) i mieszczą się w limicie kroków. Wynik (wypisane
+// wartości + stan pamięci) CodeGenVisitor zamienia na SET/PUT i SET/STORE.
+class PartialEvaluator : public ASTVisitor {
+public:
+    SymbolTable &symTab;
+    long long stepBudget;
+
+    // ========== Wynik ==========
+    size_t consumed = 0;                 ///< ile początkowych komend main policzono
+    std::vector<long long> outputs;      ///< wartości z WRITE, w kolejności
+    std::unordered_map<SymbolInfo*, long long> scalars;                  ///< znane zmienne
+    std::unordered_map<SymbolInfo*, std::map<long long, long long>> arrays; ///< znane elementy tablic
+
+    PartialEvaluator(SymbolTable &st, long long budget)
+      : symTab(st), stepBudget(budget) {}
+
+    // Metoda startowa
+    void run(ASTNode* root);
+
+    // Czy komórki symbolu trzeba odtworzyć przed resztą programu
+    bool isLive(SymbolInfo* si) const { return liveSymbols.count(si) > 0; }
+
+    void visit(ProgramAllNode&) override;
+    void visit(ProceduresNode&) override;
+    void visit(ProcHeadNode&) override;
+    void visit(ProcedureDeclNode&) override;
+    void visit(MainNode&) override;
+    void visit(DeclarationsNode&) override;
+    void visit(DeclarationVarNode&) override;
+    void visit(DeclarationArrNode&) override;
+    void visit(CommandsNode&) override;
+    void visit(CommandNode&) override;
+    void visit(ArgsDeclNode&) override;
+    void visit(ArgsNode&) override;
+    void visit(ProcCallNode&) override;
+    void visit(ExpressionNode&) override;
+    void visit(ValueNode&) override;
+    void visit(IdentifierNode&) override;
+
+private:
+    // Wpis dziennika cofania: poprzedni stan komórki (przed komendą main)
+    struct UndoEntry {
+        SymbolInfo* sym;
+        bool isArray;
+        long long index;
+        bool existed;
+        long long oldValue;
+    };
+
+    std::unordered_map<Name, ProcedureDeclNode*> procs;
+    Name currentProcedure;
+    std::unordered_map<Name, long long> iterators;         ///< iteratory FOR bieżącej ramki
+    std::unordered_map<SymbolInfo*, SymbolInfo*> arrayBindings;   ///< T-parametr => faktyczna tablica
+    std::vector<UndoEntry> undoLog;
+    std::unordered_set<SymbolInfo*> liveSymbols;
+
+    long long steps = 0;
+    long long value = 0;   ///< wynik ostatnio policzonego wyrażenia
+    bool stopped = false;  ///< trafiliśmy na READ / limit / nieznaną wartość
+
+    void stop() { stopped = true; }
+    bool tick();
+
+    SymbolInfo* resolveArray(SymbolInfo* si);
+    bool readCell(IdentifierNode &idn, long long &out);
+    void writeCell(IdentifierNode &idn, long long v);
+    void writeScalar(SymbolInfo* si, long long v);
+    void writeElement(SymbolInfo* arr, long long index, long long v);
+    void rollback();
+
+    void collectLive(ASTNode* node, Name owner,
+                     std::unordered_set<Name> &visitedProcs);
+};
+
+#endif // PARTIAL_EVAL_HPP
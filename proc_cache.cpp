@@ -0,0 +1,42 @@
+#include "proc_cache.hpp"
+
+// FNV-1a
+static uint64_t hashFingerprint(const std::string &fingerprint) {
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : fingerprint) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+bool ProcCache::get(const std::string &fingerprint, CachedProcedure &out) {
+    uint64_t k = hashFingerprint(fingerprint);
+    std::lock_guard<std::mutex> lk(m);
+    auto it = entries.find(k);
+    if (it == entries.end() || it->second.fingerprint != fingerprint) {
+        misses++;
+        return false;
+    }
+    hits++;
+    out = it->second;
+    return true;
+}
+
+void ProcCache::put(const std::string &fingerprint, CachedProcedure entry) {
+    uint64_t k = hashFingerprint(fingerprint);
+    entry.fingerprint = fingerprint;
+    std::lock_guard<std::mutex> lk(m);
+    auto it = entries.find(k);
+    if (it != entries.end()) {
+        // kolizja skrótu: nowszy wygrywa (ten sam odcisk zostaje)
+        if (it->second.fingerprint != fingerprint) it->second = std::move(entry);
+        return;
+    }
+    entries.emplace(k, std::move(entry));
+    order.push_back(k);
+    if (order.size() > kMaxEntries) {
+        entries.erase(order.front());
+        order.pop_front();
+    }
+}
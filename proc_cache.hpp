@@ -0,0 +1,65 @@
+#ifndef PROC_CACHE_HPP
+#define PROC_CACHE_HPP
+
+#include "intern.hpp"
+#include "code_folding.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//////////////////////////////////////
+// Kod jednej procedury zapamiętany do ponownego użycia
+//////////////////////////////////////
+//
+// Stan generatora procedury po genProcedureBody, w ramkach wirtualnych
+// z chwili generacji (numer ramki << kFrameShift). Przy ponownym użyciu
+// adresy przechodzą do ramek, jakie procedury mają w bieżącym programie,
+// a dalej wszystko idzie zwykłym łączeniem (linkProcedures).
+struct CachedProcedure {
+    std::string fingerprint;           ///< pełny odcisk (porównywany przy odczycie)
+    Code instructions;
+    long long ownFrame = 0;            ///< ramka procedury z chwili generacji
+    std::map<long long, Name> frames;  ///< ramka z chwili generacji => wołana procedura
+    long long frameEnd = 0;            ///< koniec pamięci ramki (memmgr po generacji)
+    CodeLayout layout;                 ///< SET-y adresów, komórki robocze
+    std::vector<std::pair<size_t, Name>> calls; ///< (pozycja JUMP, wołana procedura)
+    std::vector<size_t> trapJumps;
+    std::vector<std::pair<long long, long long>> boundInits;
+    std::vector<long long> symbolAddrs; ///< adresy symboli procedury (kolejność w tablicy symboli)
+};
+
+//////////////////////////////////////
+// Pamięć podręczna procedur według odcisku
+//////////////////////////////////////
+//
+// Odcisk (CodeGenVisitor::procFingerprint) obejmuje wszystko, od czego
+// zależy kod ciała: drzewo procedury po przekształceniach, układ jej ramki,
+// komórki wspólne oraz układ ramek wołanych procedur (ich sygnatury, nie
+// treść). Zmiana jednej procedury unieważnia więc ją samą i tylko te
+// procedury, które ją wołają i którym zmienił się jej układ parametrów.
+// Skrót odcisku tylko wybiera wpis, trafienie wymaga równego odcisku.
+// Dzielona przez kompilacje (serwer), bezpieczna dla wielu wątków.
+class ProcCache {
+public:
+    static const size_t kMaxEntries = 1 << 16;
+
+    bool get(const std::string &fingerprint, CachedProcedure &out);
+    void put(const std::string &fingerprint, CachedProcedure entry);
+
+    std::atomic<size_t> hits{0};
+    std::atomic<size_t> misses{0};
+
+private:
+    std::mutex m;
+    std::unordered_map<uint64_t, CachedProcedure> entries;
+    std::deque<uint64_t> order; ///< kolejność wstawiania (do usuwania najstarszych)
+};
+
+#endif // PROC_CACHE_HPP
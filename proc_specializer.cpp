@@ -0,0 +1,258 @@
+#include "proc_specializer.hpp"
+
+#include <algorithm>
+#include <set>
+
+// ------------------ Stałe w miejscach wywołań ------------------
+
+// Wartość wyrażenia przy znanych faktach; false => nieznana
+static bool evalConst(ASTNode* node, const ConstFacts &facts, long long &out) {
+    if (auto* val = dynamic_cast<ValueNode*>(node)) {
+        out = val->val;
+        return true;
+    }
+    if (auto* idn = dynamic_cast<IdentifierNode*>(node)) {
+        if (idn->indexExpr) return false;
+        auto it = facts.find(idn->name);
+        if (it == facts.end()) return false;
+        out = it->second;
+        return true;
+    }
+    if (auto* expr = dynamic_cast<ExpressionNode*>(node)) {
+        long long a, b;
+        return evalConst(expr->left, facts, a) && evalConst(expr->right, facts, b)
+            && evalBinary(expr->op, a, b, out);
+    }
+    return false;
+}
+
+// Część wspólna faktów z dwóch gałęzi
+static ConstFacts meet(const ConstFacts &a, const ConstFacts &b) {
+    ConstFacts result;
+    for (auto &entry : a) {
+        auto it = b.find(entry.first);
+        if (it != b.end() && it->second == entry.second) result.insert(entry);
+    }
+    return result;
+}
+
+static void forget(ConstFacts &facts, const std::set<Name> &names) {
+    for (auto &name : names) facts.erase(name);
+}
+
+// Waga bloku: licznik z profilu, a bez profilu szacunek (pętla => x8)
+long long ProcedureSpecializer::blockWeight(ASTNode* block, long long staticWeight) const {
+    long long count = profile ? profile->countOf(block) : -1;
+    return count >= 0 ? count : staticWeight;
+}
+
+void ProcedureSpecializer::scanCommands(ASTNode* node, ConstFacts &facts, long long weight) {
+    if (auto* cmds = dynamic_cast<CommandsNode*>(node)) {
+        for (auto* c : cmds->cmdList) scanCommands(c, facts, weight);
+        return;
+    }
+    auto* cmd = dynamic_cast<CommandNode*>(node);
+    if (!cmd) return;
+
+    switch (cmd->cmdKind) {
+    case CommandKind::ASSIGN: {
+        auto* target = dynamic_cast<IdentifierNode*>(cmd->children[0]);
+        if (!target || target->indexExpr) break;
+        long long v;
+        if (evalConst(cmd->children[1], facts, v)) facts[target->name] = v;
+        else facts.erase(target->name);
+        break;
+    }
+    case CommandKind::READ: {
+        auto* target = dynamic_cast<IdentifierNode*>(cmd->children[0]);
+        if (target && !target->indexExpr) facts.erase(target->name);
+        break;
+    }
+    case CommandKind::PROC_CALL: {
+        auto* pc = dynamic_cast<ProcCallNode*>(cmd->children[0]);
+        if (pc) recordCall(pc, facts, weight);
+        std::set<Name> changed;
+        collectAssigned(cmd, changed);
+        forget(facts, changed);
+        break;
+    }
+    case CommandKind::IF_THEN:
+    case CommandKind::IF_THEN_ELSE: {
+        ConstFacts thenFacts = facts;
+        scanCommands(cmd->children[1], thenFacts, blockWeight(cmd->children[1], weight));
+        ConstFacts elseFacts = facts;
+        if (cmd->cmdKind == CommandKind::IF_THEN_ELSE)
+            scanCommands(cmd->children[2], elseFacts, blockWeight(cmd->children[2], weight));
+        facts = meet(thenFacts, elseFacts);
+        break;
+    }
+    case CommandKind::WHILE:
+    case CommandKind::REPEAT_UNTIL:
+    case CommandKind::FOR_UP:
+    case CommandKind::FOR_DOWN: {
+        // W ciele pętli zostają tylko fakty o zmiennych, których ciało nie rusza
+        bool isFor = cmd->cmdKind == CommandKind::FOR_UP || cmd->cmdKind == CommandKind::FOR_DOWN;
+        ASTNode* body = cmd->children[isFor ? 3 : (cmd->cmdKind == CommandKind::WHILE ? 1 : 0)];
+        std::set<Name> changed;
+        collectAssigned(body, changed);
+        forget(facts, changed);
+
+        ConstFacts inner = facts;
+        if (isFor) {
+            auto* iter = dynamic_cast<IdentifierNode*>(cmd->children[0]);
+            if (iter) inner.erase(iter->name);
+        }
+        scanCommands(body, inner, blockWeight(body, std::min(weight, 1LL << 40) * 8));
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void ProcedureSpecializer::recordCall(ProcCallNode* pc, const ConstFacts &facts, long long weight) {
+    auto itSpec = specializable.find(pc->procName);
+    auto* an = dynamic_cast<ArgsNode*>(pc->args);
+    if (itSpec == specializable.end() || !an || an->varNames.size() != itSpec->second.size())
+        return;
+
+    std::map<size_t, long long> constArgs;
+    for (size_t i = 0; i < an->varNames.size(); i++) {
+        if (!itSpec->second[i]) continue;
+        auto it = facts.find(an->varNames[i]);
+        if (it != facts.end()) constArgs[i] = it->second;
+    }
+    if (constArgs.empty() || weight <= 0) return; // wywołanie nigdy niewykonane (profil)
+
+    Specialization &spec = candidates[{pc->procName, constArgs}];
+    spec.proc = pc->procName;
+    spec.constArgs = constArgs;
+    spec.sites.push_back({pc, weight});
+    spec.weight += weight;
+}
+
+// ------------------ Klonowanie ------------------
+
+ProcedureDeclNode* ProcedureSpecializer::makeClone(const Specialization &spec,
+                                                   Name cloneName) {
+    ProcedureDeclNode* orig = procs[spec.proc];
+    auto* clone = static_cast<ProcedureDeclNode*>(cloneAST(orig));
+    clone->procName = cloneName;
+
+    // Stałe parametry znikają z nagłówka i stają się literałami w ciele
+    auto* formals = static_cast<ArgsDeclNode*>(clone->argsDecl);
+    ConstFacts literals;
+    for (auto it = spec.constArgs.rbegin(); it != spec.constArgs.rend(); ++it) {
+        literals[formals->argNames[it->first]] = it->second;
+        formals->argNames.erase(formals->argNames.begin() + it->first);
+        formals->isArray.erase(formals->isArray.begin() + it->first);
+    }
+    clone->commands = substituteConstants(clone->commands, literals);
+
+    // Rejestracja przed upraszczaniem: kolejność przypisań jak w oryginale,
+    // więc analiza inicjalizacji da ten sam wynik
+    sem.visit(*clone);
+    simplifyCommands(dynamic_cast<CommandsNode*>(clone->commands));
+    return clone;
+}
+
+void ProcedureSpecializer::countCalls(ASTNode* node, std::map<Name, int> &calls) {
+    if (auto* cmds = dynamic_cast<CommandsNode*>(node)) {
+        for (auto* c : cmds->cmdList) countCalls(c, calls);
+    } else if (auto* cmd = dynamic_cast<CommandNode*>(node)) {
+        for (auto* c : cmd->children) countCalls(c, calls);
+    } else if (auto* pc = dynamic_cast<ProcCallNode*>(node)) {
+        calls[pc->procName]++;
+    }
+}
+
+// ------------------ Przebieg ------------------
+
+void ProcedureSpecializer::run(ASTNode* root) {
+    auto* program = dynamic_cast<ProgramAllNode*>(root);
+    if (!program || nodeBudget <= 0) return;
+    auto* procList = dynamic_cast<ProceduresNode*>(program->procedures);
+    auto* mainNode = dynamic_cast<MainNode*>(program->mainPart);
+    if (!procList || procList->procedureDecls.empty()) return;
+
+    // Parametry zwykłe, których procedura nie zmienia (ani nie przekazuje dalej)
+    for (auto* p : procList->procedureDecls) {
+        auto* pd = dynamic_cast<ProcedureDeclNode*>(p);
+        auto* formals = pd ? dynamic_cast<ArgsDeclNode*>(pd->argsDecl) : nullptr;
+        if (!formals) continue;
+        procs[pd->procName] = pd;
+        // Klon dostaje własne komórki lokalne => stan między wywołaniami by się rozdzielił
+        if (keepsStateBetweenCalls(pd)) continue;
+
+        std::set<Name> changed;
+        collectAssigned(pd->commands, changed);
+        std::vector<bool> &flags = specializable[pd->procName];
+        for (size_t i = 0; i < formals->argNames.size(); i++)
+            flags.push_back(!formals->isArray[i] && !changed.count(formals->argNames[i]));
+    }
+
+    for (auto* p : procList->procedureDecls) {
+        ConstFacts facts;
+        if (auto* pd = dynamic_cast<ProcedureDeclNode*>(p))
+            scanCommands(pd->commands, facts, blockWeight(pd, 1));
+    }
+    if (mainNode) {
+        ConstFacts facts;
+        scanCommands(mainNode->commands, facts, 1);
+    }
+
+    // Najgorętsze kombinacje najpierw, dopóki starcza budżetu
+    std::vector<Specialization*> order;
+    for (auto &entry : candidates) order.push_back(&entry.second);
+    std::stable_sort(order.begin(), order.end(),
+                     [](const Specialization* a, const Specialization* b) { return a->weight > b->weight; });
+
+    std::set<Name> specialized;
+    std::map<Name, int> cloneCount;
+    for (auto* spec : order) {
+        long long size = countNodes(procs[spec->proc]);
+        if (nodesSpent + size > nodeBudget) continue;
+
+        // '$' nie występuje w identyfikatorach języka => brak kolizji nazw
+        std::string cloneName = spec->proc + "$" + std::to_string(++cloneCount[spec->proc]);
+        int errorsBefore = sem.symTab.errors;
+        ProcedureDeclNode* clone = makeClone(*spec, cloneName);
+        if (sem.symTab.errors != errorsBefore) {
+            // nie powinno się zdarzyć; klon i tak nie zostanie użyty
+            delete clone;
+            continue;
+        }
+        nodesSpent += size;
+        clonesCreated++;
+        specialized.insert(spec->proc);
+
+        auto &decls = procList->procedureDecls;
+        auto pos = std::find(decls.begin(), decls.end(), procs[spec->proc]);
+        decls.insert(pos + 1, clone);
+
+        for (auto &site : spec->sites) {
+            site.call->procName = cloneName;
+            auto* an = static_cast<ArgsNode*>(site.call->args);
+            for (auto it = spec->constArgs.rbegin(); it != spec->constArgs.rend(); ++it)
+                an->varNames.erase(an->varNames.begin() + it->first);
+        }
+    }
+
+    // Oryginały bez pozostałych wywołań nie są już potrzebne
+    std::map<Name, int> calls;
+    for (auto* p : procList->procedureDecls) {
+        if (auto* pd = dynamic_cast<ProcedureDeclNode*>(p)) countCalls(pd->commands, calls);
+    }
+    if (mainNode) countCalls(mainNode->commands, calls);
+
+    auto &decls = procList->procedureDecls;
+    for (auto it = decls.begin(); it != decls.end();) {
+        auto* pd = dynamic_cast<ProcedureDeclNode*>(*it);
+        if (pd && specialized.count(pd->procName) && !calls[pd->procName]) {
+            delete pd;
+            it = decls.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
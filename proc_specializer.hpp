@@ -0,0 +1,59 @@
+#ifndef PROC_SPECIALIZER_HPP
+#define PROC_SPECIALIZER_HPP
+
+#include "ast.hpp"
+#include "ast_opt.hpp"
+#include "semantic_visitor.hpp"
+#include "profile.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////
+// Specjalizacja procedur dla stałych argumentów (klonowanie per miejsce wywołania)
+//////////////////////////////////////
+class ProcedureSpecializer {
+public:
+    // Klony rejestrujemy w tablicy symboli przez analizę semantyczną
+    // profile (opcjonalny): liczniki wykonań zamiast szacunku 8^głębokość pętli
+    ProcedureSpecializer(SemanticVisitor &sem, long long budget, const Profile* profile = nullptr)
+        : sem(sem), nodeBudget(budget), profile(profile) {}
+
+    // Przekształca drzewo programu (po udanej analizie semantycznej)
+    void run(ASTNode* root);
+
+    int clonesCreated = 0;     ///< liczba utworzonych klonów
+    long long nodesSpent = 0;  ///< łączny rozmiar klonów (węzły AST)
+
+private:
+    // Wywołanie z parametrami o znanej wartości
+    struct CallSite {
+        ProcCallNode* call;
+        long long weight;  // liczba wykonań (profil) albo 8^głębokość pętli
+    };
+
+    // Para (procedura, stałe parametry) i jej wywołania
+    struct Specialization {
+        Name proc;
+        std::map<size_t, long long> constArgs; // nr parametru => wartość
+        std::vector<CallSite> sites;
+        long long weight = 0;
+    };
+
+    SemanticVisitor &sem;
+    long long nodeBudget;
+    const Profile* profile;
+
+    std::map<Name, ProcedureDeclNode*> procs;
+    std::map<Name, std::vector<bool>> specializable; // parametry tylko czytane
+    std::map<std::pair<Name, std::map<size_t, long long>>, Specialization> candidates;
+
+    long long blockWeight(ASTNode* block, long long staticWeight) const;
+    void scanCommands(ASTNode* node, ConstFacts &facts, long long weight);
+    void recordCall(ProcCallNode* pc, const ConstFacts &facts, long long weight);
+    ProcedureDeclNode* makeClone(const Specialization &spec, Name cloneName);
+    void countCalls(ASTNode* node, std::map<Name, int> &calls);
+};
+
+#endif // PROC_SPECIALIZER_HPP
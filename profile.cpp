@@ -0,0 +1,95 @@
+#include "profile.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// ------------------ Numeracja bloków ------------------
+
+void Profile::number(ASTNode* block) {
+    if (block && !ids.count(block)) ids[block] = blockCount++;
+}
+
+void Profile::walk(ASTNode* node) {
+    if (auto* cmds = dynamic_cast<CommandsNode*>(node)) {
+        for (auto* c : cmds->cmdList) walk(c);
+        return;
+    }
+    auto* cmd = dynamic_cast<CommandNode*>(node);
+    if (!cmd) return;
+
+    switch (cmd->cmdKind) {
+    case CommandKind::IF_THEN:
+    case CommandKind::IF_THEN_ELSE:
+        for (size_t i = 1; i < cmd->children.size(); i++) {
+            number(cmd->children[i]);
+            walk(cmd->children[i]);
+        }
+        break;
+    case CommandKind::WHILE:
+        number(cmd->children[1]);
+        walk(cmd->children[1]);
+        break;
+    case CommandKind::REPEAT_UNTIL:
+        number(cmd->children[0]);
+        walk(cmd->children[0]);
+        break;
+    case CommandKind::FOR_UP:
+    case CommandKind::FOR_DOWN:
+        number(cmd->children[3]);
+        walk(cmd->children[3]);
+        break;
+    default:
+        break;
+    }
+}
+
+void Profile::assignIds(ASTNode* root) {
+    auto* program = dynamic_cast<ProgramAllNode*>(root);
+    if (!program) return;
+    if (auto* procs = dynamic_cast<ProceduresNode*>(program->procedures)) {
+        for (auto* p : procs->procedureDecls) {
+            auto* pd = dynamic_cast<ProcedureDeclNode*>(p);
+            if (!pd) continue;
+            number(pd);
+            walk(pd->commands);
+        }
+    }
+    if (auto* mn = dynamic_cast<MainNode*>(program->mainPart)) walk(mn->commands);
+}
+
+// ------------------ Dane ------------------
+
+bool Profile::load(const std::string &path, std::ostream &err) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        err << "Nie można otworzyć profilu " << path << "\n";
+        return false;
+    }
+    // Wyjście maszyny: liczby, ewentualnie z prefiksem "> " albo innym tekstem
+    std::vector<long long> numbers;
+    std::string tok;
+    while (in >> tok) {
+        std::istringstream is(tok);
+        long long v;
+        if (is >> v && is.eof()) numbers.push_back(v);
+    }
+    if ((long long)numbers.size() < blockCount) {
+        err << "Profil " << path << " ma za mało liczników (" << numbers.size()
+                  << " < " << blockCount << ") - pomijam\n";
+        return false;
+    }
+    counts.assign(numbers.end() - blockCount, numbers.end());
+    return true;
+}
+
+int Profile::idOf(const ASTNode* block) const {
+    auto it = ids.find(block);
+    return it == ids.end() ? -1 : it->second;
+}
+
+long long Profile::countOf(const ASTNode* block) const {
+    int id = idOf(block);
+    if (id < 0 || counts.empty()) return -1;
+    return counts[id];
+}
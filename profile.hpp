@@ -0,0 +1,45 @@
+#ifndef PROFILE_HPP
+#define PROFILE_HPP
+
+#include "ast.hpp"
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//////////////////////////////////////
+// Profil wykonania: liczniki bloków zbierane na maszynie
+//////////////////////////////////////
+//
+// Bloki (numerowane w stałej kolejności po analizie semantycznej, przed
+// przekształceniami): wejście procedury, gałęzie IF, ciała pętli.
+// --profile-gen: kod zwiększa licznik bloku przy każdym wejściu i przed HALT
+//                wypisuje wszystkie liczniki (PUT) po wyjściu programu.
+// --profile-use=PLIK: PLIK to wyjście takiego przebiegu; liczniki to ostatnie
+//                liczby w pliku.
+class Profile {
+public:
+    // Numeruje bloki drzewa (to samo źródło => te same numery)
+    void assignIds(ASTNode* root);
+
+    // Wczytuje liczniki; false => brak pliku albo za mało liczb (powód do err)
+    bool load(const std::string &path, std::ostream &err = std::cerr);
+
+    int size() const { return blockCount; }
+    bool loaded() const { return !counts.empty(); }
+
+    // -1 => blok bez numeru (np. klon) albo brak danych
+    int idOf(const ASTNode* block) const;
+    long long countOf(const ASTNode* block) const;
+
+private:
+    std::unordered_map<const ASTNode*, int> ids;
+    int blockCount = 0;
+    std::vector<long long> counts;
+
+    void number(ASTNode* block);
+    void walk(ASTNode* node);
+};
+
+#endif // PROFILE_HPP
@@ -0,0 +1,99 @@
+#include "scalar_replace.hpp"
+
+// ------------------ Użycia ------------------
+
+void ScalarReplacer::collect(ASTNode* node) {
+    if (!node) return;
+    if (auto* cmds = dynamic_cast<CommandsNode*>(node)) {
+        for (auto* c : cmds->cmdList) collect(c);
+    } else if (auto* cmd = dynamic_cast<CommandNode*>(node)) {
+        for (auto* c : cmd->children) collect(c);
+    } else if (auto* pc = dynamic_cast<ProcCallNode*>(node)) {
+        if (auto* an = dynamic_cast<ArgsNode*>(pc->args))
+            passed.insert(an->varNames.begin(), an->varNames.end());
+    } else if (auto* e = dynamic_cast<ExpressionNode*>(node)) {
+        collect(e->left);
+        collect(e->right);
+    } else if (auto* idn = dynamic_cast<IdentifierNode*>(node)) {
+        uses[idn->name].push_back(idn);
+        collect(idn->indexExpr);
+    }
+}
+
+// ------------------ Przebieg ------------------
+
+static Name cellName(Name arr, long long index) {
+    // '$' nie występuje w identyfikatorach języka => brak kolizji nazw
+    return arr + "$" + std::to_string(index);
+}
+
+void ScalarReplacer::runUnit(ASTNode* decls, ASTNode* cmds, Name owner) {
+    auto* dn = dynamic_cast<DeclarationsNode*>(decls);
+    if (!dn) return;
+    uses.clear();
+    passed.clear();
+    collect(cmds);
+
+    NodeList newDecls;
+    for (auto* d : dn->declList) {
+        auto* da = dynamic_cast<DeclarationArrNode*>(d);
+        if (!da || passed.count(da->arrName)) {
+            newDecls.push_back(d);
+            continue;
+        }
+        // Każde użycie: stały indeks w zakresie (iterator FOR o tej nazwie => bez indeksu)
+        std::vector<IdentifierNode*> &list = uses[da->arrName];
+        bool constantOnly = true;
+        for (auto* idn : list) {
+            auto* idx = dynamic_cast<ValueNode*>(idn->indexExpr);
+            if (!idx || idx->val < da->lowerBound || idx->val > da->upperBound) {
+                constantOnly = false;
+                break;
+            }
+        }
+        if (!constantOnly) {
+            newDecls.push_back(d);
+            continue;
+        }
+
+        std::set<long long> used;
+        for (auto* idn : list) {
+            used.insert(static_cast<ValueNode*>(idn->indexExpr)->val);
+        }
+        for (long long index : used) {
+            SymbolInfo info;
+            info.kind = SymbolKind::VAR;
+            info.name = cellName(da->arrName, index);
+            info.initialized = true; // inicjalizację sprawdziła już analiza semantyczna
+            info.ownerProcName = owner;
+            if (owner.empty()) symTab.addGlobalSymbol(info, da->getLine());
+            else symTab.addLocalSymbol(info, da->getLine());
+            newDecls.push_back(new DeclarationVarNode(da->getLine(), info.name));
+        }
+        for (auto* idn : list) {
+            idn->name = cellName(da->arrName, static_cast<ValueNode*>(idn->indexExpr)->val);
+            idn->sym = symTab.find(idn->name, owner);
+            delete idn->indexExpr;
+            idn->indexExpr = nullptr;
+        }
+        delete da;
+        arraysReplaced++;
+        cellsCreated += used.size();
+    }
+    dn->declList.swap(newDecls);
+}
+
+void ScalarReplacer::run(ASTNode* root) {
+    auto* program = dynamic_cast<ProgramAllNode*>(root);
+    if (!program) return;
+
+    if (auto* procs = dynamic_cast<ProceduresNode*>(program->procedures)) {
+        for (auto* p : procs->procedureDecls) {
+            // tablice-parametry siedzą w argsDecl, więc tu ich nie ma
+            if (auto* pd = dynamic_cast<ProcedureDeclNode*>(p))
+                runUnit(pd->localDecls, pd->commands, pd->procName);
+        }
+    }
+    if (auto* mn = dynamic_cast<MainNode*>(program->mainPart))
+        runUnit(mn->declarations, mn->commands, "");
+}
@@ -0,0 +1,39 @@
+#ifndef SCALAR_REPLACE_HPP
+#define SCALAR_REPLACE_HPP
+
+#include "ast.hpp"
+#include "symtable.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////
+// Zamiana tablic indeksowanych tylko stałymi na osobne zmienne
+//////////////////////////////////////
+//
+// t[k] (każde użycie t ze stałym indeksem w zakresie, t nie jest parametrem
+// ani argumentem wywołania) => zmienna "t$k". Nieużywane elementy znikają.
+// Dalsze przebiegi (stałe, żywotność, śledzenie p0) widzą wtedy zwykłe
+// zmienne. Uruchamiane po analizie semantycznej i klonowaniu procedur.
+class ScalarReplacer {
+public:
+    ScalarReplacer(SymbolTable &symTab) : symTab(symTab) {}
+
+    void run(ASTNode* root);
+
+    int arraysReplaced = 0; ///< liczba zamienionych tablic
+    int cellsCreated = 0;   ///< liczba utworzonych zmiennych
+
+private:
+    SymbolTable &symTab;
+
+    std::map<Name, std::vector<IdentifierNode*>> uses; ///< użycia nazw w bieżącej jednostce
+    std::set<Name> passed;                             ///< nazwy przekazane do procedur
+
+    void collect(ASTNode* node);
+    void runUnit(ASTNode* decls, ASTNode* cmds, Name owner);
+};
+
+#endif // SCALAR_REPLACE_HPP
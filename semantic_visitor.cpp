@@ -66,7 +66,7 @@ void SemanticVisitor::visit(ProcedureDeclNode &node) {
     }
 
     // 2. Chronimy przed rekurencją
-    std::string oldProc = currentProcedure;
+    Name oldProc = currentProcedure;
     currentProcedure = node.procName;
 
     // 3. (Nie czyścimy localScope!)
@@ -253,6 +253,7 @@ void SemanticVisitor::visit(CommandNode &node) {
                     info.ownerProcName = currentProcedure;
                     // Dodajemy do currentScope
                     symTab.addLocalSymbol(info, iter->getLine());
+                    iter->sym = symTab.find(iter->name, currentProcedure);
 
                     currentForIterator = iter->name;
                     inFor = true;
@@ -266,7 +267,7 @@ void SemanticVisitor::visit(CommandNode &node) {
                 if (iter) {
                     symTab.removeLocalSymbol(iter->name, currentProcedure);
                 }
-                currentForIterator.clear();
+                currentForIterator = Name();
                 inFor = false;
             }
             break;
@@ -284,6 +285,7 @@ void SemanticVisitor::visit(CommandNode &node) {
                     info.ownerProcName = currentProcedure;
                     
                     symTab.addLocalSymbol(info, iter->getLine());
+                    iter->sym = symTab.find(iter->name, currentProcedure);
 
                     currentForIterator = iter->name;
                     inFor = true;
@@ -295,7 +297,7 @@ void SemanticVisitor::visit(CommandNode &node) {
                 if (iter) {
                     symTab.removeLocalSymbol(iter->name, currentProcedure);
                 }
-                currentForIterator.clear();
+                currentForIterator = Name();
                 inFor = false;
             }
             break;
@@ -442,8 +444,9 @@ void SemanticVisitor::visit(ValueNode &node) {
 }
 
 void SemanticVisitor::visit(IdentifierNode &node) {
-    // Sprawdzamy symbol
-    SymbolInfo* si = symTab.lookup(node.name, currentProcedure);
+    // Sprawdzamy symbol; indeks zostaje w węźle dla dalszych przebiegów
+    node.sym = symTab.find(node.name, currentProcedure);
+    SymbolInfo* si = node.sym < 0 ? nullptr : &symTab.at(node.sym);
     if (!si) {
         symTab.reportError("Użycie niezadeklarowanego identyfikatora \"" + node.name + "\"", node.getLine());
         return;
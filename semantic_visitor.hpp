@@ -14,10 +14,10 @@ public:
     bool collectingParams = false;
 
 
-    std::string currentProcedure;
+    Name currentProcedure;
 
 
-    std::string currentForIterator;
+    Name currentForIterator;
     bool inFor = false; // flaga, czy jesteśmy w pętli for
 
 
@@ -0,0 +1,387 @@
+#include "server.hpp"
+#include "compiler.hpp"
+#include "proc_cache.hpp"
+#include "thread_pool.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// ------------------ gniazdo ------------------
+
+bool makeAddress(const std::string &path, sockaddr_un &addr) {
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+int connectTo(const std::string &path) {
+    sockaddr_un addr;
+    if (!makeAddress(path, addr)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (const sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool writeAll(int fd, const std::string &data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = write(fd, data.data() + done, data.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += (size_t)n;
+    }
+    return true;
+}
+
+// Do końca strumienia (druga strona zamknęła zapis)
+bool readAll(int fd, std::string &data) {
+    char buf[65536];
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        if (n == 0) return true;
+        data.append(buf, (size_t)n);
+    }
+}
+
+// Żądanie klienta: do końca strumienia, ale najwyżej kMaxRequest bajtów
+// i kRequestTimeout sekund łącznie — klient, który nic nie wysyła albo nie
+// zamyka zapisu, nie zajmuje wątku puli na zawsze
+const size_t kMaxRequest = 1 << 20;
+const int kRequestTimeout = 10;
+
+bool readRequest(int fd, std::string &data) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(kRequestTimeout);
+    char buf[65536];
+    for (;;) {
+        auto left = std::chrono::duration_cast<std::chrono::microseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0) return false;
+        timeval tv;
+        tv.tv_sec = left / 1000000;
+        tv.tv_usec = left % 1000000;
+        if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0) return false;
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false; // także EAGAIN po upływie czasu
+        if (n == 0) return true;
+        if (data.size() + (size_t)n > kMaxRequest) return false;
+        data.append(buf, (size_t)n);
+    }
+}
+
+std::vector<std::string> splitFields(const std::string &data) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    for (size_t i = 0; i < data.size(); i++) {
+        if (data[i] != '\0') continue;
+        fields.push_back(data.substr(start, i - start));
+        start = i + 1;
+    }
+    return fields;
+}
+
+std::string joinFields(const std::vector<std::string> &fields) {
+    std::string data;
+    for (const auto &f : fields) {
+        data += f;
+        data += '\0';
+    }
+    return data;
+}
+
+// Wysyła żądanie i czyta odpowiedź; false => brak serwera / zerwane połączenie
+bool request(const std::string &socketPath, const std::vector<std::string> &fields,
+             int &rc, std::string &log, std::string &err) {
+    int fd = connectTo(socketPath);
+    if (fd < 0) return false;
+    std::string reply;
+    bool ok = writeAll(fd, joinFields(fields)) && shutdown(fd, SHUT_WR) == 0 && readAll(fd, reply);
+    close(fd);
+    if (!ok) return false;
+
+    size_t eol = reply.find('\n');
+    if (eol == std::string::npos) return false;
+    std::istringstream header(reply.substr(0, eol));
+    size_t logLen = 0, errLen = 0;
+    if (!(header >> rc >> logLen >> errLen) || eol + 1 + logLen + errLen != reply.size()) return false;
+    log = reply.substr(eol + 1, logLen);
+    err = reply.substr(eol + 1 + logLen);
+    return true;
+}
+
+bool readFile(const std::string &path, std::string &data) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return false;
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    data = ss.str();
+    return true;
+}
+
+// ------------------ pamięć podręczna wyników ------------------
+
+// FNV-1a, 64 bity
+uint64_t hashBytes(uint64_t h, const std::string &data) {
+    for (unsigned char c : data) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+//////////////////////////////////////
+// Kod maszyny według skrótu wejścia kompilacji
+//////////////////////////////////////
+//
+// Kluczem jest wejście kompilacji (opcje kodu, treść profilu, źródło) — sama
+// treść, nie ścieżka ani czas modyfikacji. Skrót tylko wybiera wpis: wpis
+// trzyma pełne wejście i porównuje je przy odczycie, więc kolizja skrótu
+// daje chybienie, a nie cudzy kod. Po przekroczeniu limitu wypadają najstarsze.
+class OutputCache {
+public:
+    static const size_t kMaxEntries = 1 << 16;
+
+    static std::string keyMaterial(const CompileOptions &opts, const std::string &profile,
+                                   const std::string &source) {
+        std::string material;
+        for (const auto &arg : opts.codeArgs()) {
+            material += arg;
+            material += '\0';
+        }
+        material += profile;
+        material += '\0';
+        material += source;
+        return material;
+    }
+
+    bool get(const std::string &material, Code &code) {
+        uint64_t k = hashBytes(14695981039346656037ull, material);
+        std::lock_guard<std::mutex> lk(m);
+        auto it = entries.find(k);
+        if (it == entries.end() || it->second.material != material) return false;
+        code = it->second.code;
+        return true;
+    }
+
+    void put(const std::string &material, const Code &code) {
+        uint64_t k = hashBytes(14695981039346656037ull, material);
+        std::lock_guard<std::mutex> lk(m);
+        auto res = entries.emplace(k, Entry{material, code});
+        if (!res.second) {
+            res.first->second = Entry{material, code}; // kolizja skrótu: nowszy wygrywa
+            return;
+        }
+        order.push_back(k);
+        if (order.size() > kMaxEntries) {
+            entries.erase(order.front());
+            order.pop_front();
+        }
+    }
+
+private:
+    struct Entry {
+        std::string material; ///< pełne wejście (porównywane przy odczycie)
+        Code code;
+    };
+
+    std::mutex m;
+    std::unordered_map<uint64_t, Entry> entries;
+    std::deque<uint64_t> order; ///< kolejność wstawiania (do usuwania najstarszych)
+};
+
+// ------------------ serwer ------------------
+
+class CompileServer {
+public:
+    explicit CompileServer(int listenFd) : listenFd(listenFd) {}
+
+    void handle(int fd);
+
+    std::atomic<bool> stopping{false};
+    std::atomic<size_t> requests{0};
+    std::atomic<size_t> hits{0};
+    ProcCache procCache; ///< procedury z poprzednich kompilacji (plik zmieniony tylko częściowo)
+
+private:
+    int listenFd;
+    OutputCache cache;
+
+    int compile(const std::string &srcPath, const std::string &outPath, const CompileOptions &opts,
+                std::ostream &log, std::ostream &err);
+};
+
+int CompileServer::compile(const std::string &srcPath, const std::string &outPath,
+                           const CompileOptions &opts, std::ostream &log, std::ostream &err) {
+    std::string source;
+    if (!readFile(srcPath, source)) {
+        err << "Nie można otworzyć pliku " << srcPath << "\n";
+        return 2;
+    }
+    // Profil wpływa na kod, więc jego treść jest częścią klucza
+    std::string profile;
+    if (!opts.profileUse.empty()) readFile(opts.profileUse, profile);
+
+    std::string material = OutputCache::keyMaterial(opts, profile, source);
+    Code code;
+    if (cache.get(material, code)) {
+        hits++;
+        log << "Wynik z pamięci podręcznej serwera\n";
+        return writeCode(outPath, code, log, err);
+    }
+
+    // Własna kopia zamiast mapowania: plik skrócony w trakcie kompilacji
+    // zakończyłby mapowanie SIGBUS-em całego serwera
+    int res = compileSource(source.data(), source.size(), opts, code, log, err, &procCache);
+    if (res != 0) return res;
+
+    cache.put(material, code);
+    return writeCode(outPath, code, log, err);
+}
+
+void CompileServer::handle(int fd) {
+    std::string data;
+    std::vector<std::string> fields;
+    if (readRequest(fd, data)) fields = splitFields(data);
+    // odpowiedź też z limitem czasu: klient, który nie czyta, nie blokuje wątku
+    timeval tv;
+    tv.tv_sec = kRequestTimeout;
+    tv.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    std::ostringstream log, err;
+    int rc = 1;
+    if (fields.size() == 1 && fields[0] == "STOP") {
+        stopping = true;
+        shutdown(listenFd, SHUT_RDWR); // przerywa accept() w pętli głównej
+        log << "Serwer zatrzymany\n";
+        rc = 0;
+    } else if (fields.size() >= 3 && fields[0] == "COMPILE") {
+        requests++;
+        // Opcje od klienta nakładane na domyślne, nie na opcje serwera
+        CompileOptions opts;
+        bool ok = true;
+        for (size_t i = 3; i < fields.size(); i++) {
+            if (!opts.parse(fields[i])) {
+                err << "Nieznana opcja " << fields[i] << "\n";
+                ok = false;
+            }
+        }
+        opts.jobs = 1; // równoległość już na poziomie żądań
+        if (ok) {
+            try {
+                rc = compile(fields[1], fields[2], opts, log, err);
+            } catch (const std::exception &e) {
+                err << "Wyjątek: " << e.what() << "\n";
+                rc = 1;
+            }
+        }
+    } else {
+        err << "Niepoprawne żądanie\n";
+    }
+
+    std::string l = log.str(), e = err.str();
+    writeAll(fd, std::to_string(rc) + " " + std::to_string(l.size()) + " " +
+                 std::to_string(e.size()) + "\n" + l + e);
+    close(fd);
+}
+
+} // namespace
+
+int runServer(const std::string &socketPath, const CompileOptions &opts) {
+    sockaddr_un addr;
+    if (!makeAddress(socketPath, addr)) {
+        std::cerr << "Za długa ścieżka gniazda " << socketPath << "\n";
+        return 2;
+    }
+    // Klient, który zniknął w trakcie odpowiedzi, nie może zabić serwera
+    signal(SIGPIPE, SIG_IGN);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socketPath.c_str()); // gniazdo po poprzednim serwerze
+    if (fd < 0 || bind(fd, (const sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        std::cerr << "Nie można nasłuchiwać na " << socketPath << ": " << std::strerror(errno) << "\n";
+        if (fd >= 0) close(fd);
+        return 2;
+    }
+    std::cout << "Serwer kompilacji nasłuchuje na " << socketPath << std::endl;
+
+    CompileServer server(fd);
+    {
+        WorkStealingPool pool(opts.jobs);
+        for (;;) {
+            int client = accept(fd, nullptr, nullptr);
+            if (client < 0) {
+                if (server.stopping) break;
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                std::cerr << "accept: " << std::strerror(errno) << "\n";
+                break;
+            }
+            pool.submit([&server, client]() { server.handle(client); });
+        }
+        pool.wait();
+    }
+    close(fd);
+    unlink(socketPath.c_str());
+
+    std::cout << "Obsłużono " << server.requests << " kompilacji, z pamięci podręcznej: "
+              << server.hits << ", procedur z pamięci podręcznej: " << server.procCache.hits
+              << "/" << (server.procCache.hits + server.procCache.misses) << std::endl;
+    return 0;
+}
+
+int compileViaServer(const std::string &socketPath, const std::string &srcPath,
+                     const std::string &outPath, CompileOptions opts, bool &reached) {
+    // Serwer ma inny katalog bieżący: ścieżki bezwzględne
+    namespace fs = std::filesystem;
+    if (!opts.profileUse.empty()) opts.profileUse = fs::absolute(opts.profileUse).string();
+    std::vector<std::string> fields = {"COMPILE", fs::absolute(srcPath).string(),
+                                       fs::absolute(outPath).string()};
+    for (const auto &arg : opts.codeArgs()) fields.push_back(arg);
+
+    int rc = 1;
+    std::string log, err;
+    reached = request(socketPath, fields, rc, log, err);
+    if (!reached) return 1;
+    std::cout << log;
+    std::cerr << err;
+    return rc;
+}
+
+int stopServer(const std::string &socketPath) {
+    int rc = 1;
+    std::string log, err;
+    if (!request(socketPath, {"STOP"}, rc, log, err)) {
+        std::cerr << "Brak serwera na " << socketPath << "\n";
+        return 1;
+    }
+    std::cout << log;
+    std::cerr << err;
+    return rc;
+}
@@ -0,0 +1,34 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include "options.hpp"
+
+#include <string>
+
+//////////////////////////////////////
+// Serwer kompilacji na gnieździe uniksowym
+//////////////////////////////////////
+//
+// Proces z --server=GNIAZDO działa stale: ma gotową pulę wątków, tablicę
+// nazw i pamięć podręczną wyników adresowaną skrótem treści (źródło, opcje
+// kodu i treść profilu). Niezmieniony plik z tymi samymi opcjami nie jest
+// kompilowany drugi raz — serwer tylko zapisuje zapamiętany kod.
+//
+// Kompilator z --connect=GNIAZDO jest cienkim klientem: przekazuje ścieżki
+// (bezwzględne) i opcje, wypisuje komunikaty serwera i kończy się jego kodem.
+//
+// Protokół: jedno połączenie => jedno żądanie. Klient wysyła pola zakończone
+// '\0' ("COMPILE", źródło, wynik, opcje... albo "STOP") i zamyka zapis;
+// serwer odpowiada linią "kod długość_log długość_err" i tekstami komunikatów.
+
+// Pętla serwera (opts.jobs wątków obsługi); wraca po żądaniu STOP
+int runServer(const std::string &socketPath, const CompileOptions &opts);
+
+// Kompilacja przez serwer; reached == false => brak serwera (nic nie zrobiono)
+int compileViaServer(const std::string &socketPath, const std::string &srcPath,
+                     const std::string &outPath, CompileOptions opts, bool &reached);
+
+// Zatrzymanie serwera; 0 => zatrzymany, 1 => brak serwera
+int stopServer(const std::string &socketPath);
+
+#endif // SERVER_HPP
@@ -0,0 +1,264 @@
+#include "parser.tab.hh"
+#include "parse_context.hpp"
+#include "intern.hpp"
+
+#include <climits>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Skaner Flexa (lexer.l) pod własną nazwą
+int flexLex(YYSTYPE* lvalp, YYLTYPE* llocp, yyscan_t scanner);
+
+//////////////////////////////////////
+// Skaner bufora: te same tokeny co lexer.l, bez Flexa
+//////////////////////////////////////
+//
+// Długie ciągi (odstępy, identyfikatory, liczby) klasyfikowane po 16 bajtów
+// naraz (SSE2), komentarz do końca linii przez memchr. Słowa kluczowe,
+// operatory i reszta znak po znaku. Zgodność z Flexem:
+//   - słowo kluczowe: najdłuższe pasujące na początku ciągu wielkich liter
+//     ("ENDFOR" przed "END", "TOO" => TO i pominięte "O");
+//   - znak, który nie zaczyna żadnego tokenu, jest pomijany (Flex wypisywał
+//     go na stdout regułą domyślną);
+//   - '#' bez końca linii do końca pliku nie jest komentarzem.
+class SourceScanner {
+public:
+    SourceScanner(const char* data, size_t size, ParseContext &ctx)
+        : p(data), end(data + size), ctx(ctx) {}
+
+    int next(YYSTYPE &lval, YYLTYPE &lloc); // 0 => koniec wejścia
+
+private:
+    const char* p;
+    const char* end;
+    ParseContext &ctx;
+
+    int token(int tok, YYSTYPE &lval, YYLTYPE &lloc);
+    int number(const char* start, YYSTYPE &lval);
+    int variable(const char* start, YYSTYPE &lval);
+    int keyword(YYSTYPE &lval, YYLTYPE &lloc);
+};
+
+// ------------------ klasy znaków ------------------
+
+static inline bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+static inline bool isLowerOrUnderscore(char c) { return (c >= 'a' && c <= 'z') || c == '_'; }
+static inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+#if defined(__SSE2__)
+// Bity 1 dla bajtów z przedziału [lo, hi] (bajty >= 0x80 są ujemne => poza)
+static inline unsigned rangeMask(__m128i v, char lo, char hi) {
+    __m128i ge = _mm_cmpgt_epi8(v, _mm_set1_epi8((char)(lo - 1)));
+    __m128i le = _mm_cmplt_epi8(v, _mm_set1_epi8((char)(hi + 1)));
+    return (unsigned)_mm_movemask_epi8(_mm_and_si128(ge, le));
+}
+
+static inline unsigned byteMask(__m128i v, char c) {
+    return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+}
+#endif
+
+// Pomija [ \t\r\n]*, licząc nowe linie
+static const char* skipBlanks(const char* p, const char* end, uint64_t &lines) {
+#if defined(__SSE2__)
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        unsigned nl = byteMask(v, '\n');
+        unsigned blank = nl | byteMask(v, ' ') | byteMask(v, '\t') | byteMask(v, '\r');
+        if (blank == 0xFFFF) {
+            lines += __builtin_popcount(nl);
+            p += 16;
+            continue;
+        }
+        int n = __builtin_ctz(~blank);              // pierwszy znak spoza odstępów
+        lines += __builtin_popcount(nl & ((1u << n) - 1));
+        return p + n;
+    }
+#endif
+    for (; p < end && isBlank(*p); p++) {
+        if (*p == '\n') ++lines;
+    }
+    return p;
+}
+
+// Koniec ciągu [_a-z]*
+static const char* spanIdentifier(const char* p, const char* end) {
+#if defined(__SSE2__)
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        unsigned in = rangeMask(v, 'a', 'z') | byteMask(v, '_');
+        if (in != 0xFFFF) return p + __builtin_ctz(~in);
+        p += 16;
+    }
+#endif
+    while (p < end && isLowerOrUnderscore(*p)) p++;
+    return p;
+}
+
+// Koniec ciągu [0-9]*
+static const char* spanDigits(const char* p, const char* end) {
+#if defined(__SSE2__)
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        unsigned in = rangeMask(v, '0', '9');
+        if (in != 0xFFFF) return p + __builtin_ctz(~in);
+        p += 16;
+    }
+#endif
+    while (p < end && isDigit(*p)) p++;
+    return p;
+}
+
+// ------------------ tokeny ------------------
+
+// Jak lex() w lexer.l (także sposób ustawiania lloc)
+int SourceScanner::token(int tok, YYSTYPE &lval, YYLTYPE &lloc) {
+    lloc.first_line = ctx.line;
+    lloc.last_line += ctx.line;
+    lval.ptoken.line = ctx.line;
+    lval.ptoken.value = 0;
+    lval.ptoken.sym = 0;
+    return tok;
+}
+
+// Jak lex_num(): strtoull, czyli przy przepełnieniu ULLONG_MAX
+int SourceScanner::number(const char* start, YYSTYPE &lval) {
+    unsigned long long value = 0;
+    bool overflow = false;
+    for (const char* q = start; q < p; q++) {
+        unsigned d = (unsigned)(*q - '0');
+        if (value > (ULLONG_MAX - d) / 10) overflow = true;
+        value = value * 10 + d;
+    }
+    lval.ptoken.line = ctx.line;
+    lval.ptoken.value = overflow ? ULLONG_MAX : value;
+    lval.ptoken.sym = 0;
+    return YY_NUM;
+}
+
+int SourceScanner::variable(const char* start, YYSTYPE &lval) {
+    lval.ptoken.value = 0;
+    lval.ptoken.line = ctx.line;
+    lval.ptoken.sym = StringTable::intern(start, (size_t)(p - start));
+    return YY_VARIABLE;
+}
+
+int SourceScanner::keyword(YYSTYPE &lval, YYLTYPE &lloc) {
+    static const struct { const char* text; size_t len; int tok; } kKeywords[] = {
+        {"PROGRAM", 7, YY_PROGRAM}, {"IS", 2, YY_IS}, {"END", 3, YY_END},
+        {"PROCEDURE", 9, YY_PROCEDURE}, {"BEGIN", 5, YY_BEGIN},
+        {"IF", 2, YY_IF}, {"THEN", 4, YY_THEN}, {"ELSE", 4, YY_ELSE}, {"ENDIF", 5, YY_ENDIF},
+        {"WHILE", 5, YY_WHILE}, {"DO", 2, YY_DO}, {"ENDWHILE", 8, YY_ENDWHILE},
+        {"REPEAT", 6, YY_REPEAT}, {"UNTIL", 5, YY_UNTIL},
+        {"FOR", 3, YY_FOR}, {"FROM", 4, YY_FROM}, {"TO", 2, YY_TO},
+        {"DOWNTO", 6, YY_DOWNTO}, {"ENDFOR", 6, YY_ENDFOR},
+        {"READ", 4, YY_READ}, {"WRITE", 5, YY_WRITE}, {"T", 1, YY_T},
+    };
+    size_t left = (size_t)(end - p);
+    size_t bestLen = 0;
+    int best = 0;
+    for (const auto &kw : kKeywords) {
+        if (kw.len > bestLen && kw.len <= left && std::memcmp(p, kw.text, kw.len) == 0) {
+            bestLen = kw.len;
+            best = kw.tok;
+        }
+    }
+    if (bestLen == 0) return -1;
+    p += bestLen;
+    return token(best, lval, lloc);
+}
+
+int SourceScanner::next(YYSTYPE &lval, YYLTYPE &lloc) {
+    for (;;) {
+        p = skipBlanks(p, end, ctx.line);
+        if (p == end) return 0;
+
+        const char* start = p;
+        char c = *p;
+        if (isLowerOrUnderscore(c)) {
+            p = spanIdentifier(p + 1, end);
+            return variable(start, lval);
+        }
+        if (isDigit(c)) {
+            p = spanDigits(p + 1, end);
+            return number(start, lval);
+        }
+        if (c >= 'A' && c <= 'Z') {
+            int tok = keyword(lval, lloc);
+            if (tok >= 0) return tok;
+            p++; // wielka litera spoza słów kluczowych
+            continue;
+        }
+
+        char n = (end - p >= 2) ? p[1] : '\0';
+        p++;
+        switch (c) {
+        case '#': {
+            const char* nl = (const char*)std::memchr(p, '\n', (size_t)(end - p));
+            if (nl) {
+                p = nl + 1;
+                ++ctx.line;
+            }
+            continue;
+        }
+        case ';': return token(YY_SEMICOLON, lval, lloc);
+        case ',': return token(YY_COMMA, lval, lloc);
+        case '+': return token(YY_ADD, lval, lloc);
+        case '-': return token(YY_SUB, lval, lloc);
+        case '*': return token(YY_MUL, lval, lloc);
+        case '/': return token(YY_DIV, lval, lloc);
+        case '%': return token(YY_MOD, lval, lloc);
+        case '(': return token(YY_L_BRACKET_R, lval, lloc);
+        case ')': return token(YY_R_BRACKET_R, lval, lloc);
+        case '[': return token(YY_L_BRACKET_S, lval, lloc);
+        case ']': return token(YY_R_BRACKET_S, lval, lloc);
+        case '=': return token(YY_EQ, lval, lloc);
+        case ':':
+            if (n == '=') {
+                p++;
+                return token(YY_ASSIGN, lval, lloc);
+            }
+            return token(YY_ARR_RANGE, lval, lloc);
+        case '<':
+            if (n == '=') {
+                p++;
+                return token(YY_LEQT, lval, lloc);
+            }
+            return token(YY_LT, lval, lloc);
+        case '>':
+            if (n == '=') {
+                p++;
+                return token(YY_GEQT, lval, lloc);
+            }
+            return token(YY_GT, lval, lloc);
+        case '!':
+            if (n == '=') {
+                p++;
+                return token(YY_NEQ, lval, lloc);
+            }
+            continue; // samo '!' nie jest tokenem
+        default:
+            continue; // znak spoza języka
+        }
+    }
+}
+
+// ------------------ wejście parsera ------------------
+
+// yylex parsera: skaner bufora albo Flex (parseProgram)
+int yylex(YYSTYPE* lvalp, YYLTYPE* llocp, yyscan_t scanner, ParseContext &ctx) {
+    if (ctx.source) return ctx.source->next(*lvalp, *llocp);
+    return flexLex(lvalp, llocp, scanner);
+}
+
+int parseBuffer(const char* data, size_t size, ParseContext &ctx) {
+    SourceScanner scanner(data, size, ctx);
+    ctx.source = &scanner;
+    int res = yyparse(nullptr, ctx);
+    ctx.source = nullptr;
+    return res;
+}
@@ -1,12 +1,15 @@
 #ifndef SYMTABLE_HPP
 #define SYMTABLE_HPP
 
+#include <deque>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <iostream>
 #include <cstdint>
 
+#include "intern.hpp"
+
 enum class SymbolKind {
     VAR,
     ARR,
@@ -15,7 +18,7 @@ enum class SymbolKind {
 
 struct SymbolInfo {
     SymbolKind kind;
-    std::string name;
+    Name name;
     bool initialized = false; 
     bool isForIterator = false;
     bool ifParam = false; 
@@ -30,29 +33,38 @@ struct SymbolInfo {
     // Dla procedur
     std::vector<SymbolKind> paramKinds; 
     std::vector<long long> paramAddrs; 
-    std::vector<std::string> paramNames;
+    std::vector<Name> paramNames;
     std::vector<SymbolInfo*> paramSymbols;
     long long returnAddr = -1;
 
     // nazwa procedury, do której należy symbol ("" dla main / global)
-    std::string ownerProcName; 
+    Name ownerProcName; 
 };
 
+// Wszystkie symbole leżą w jednym magazynie (symbols), zasięgi trzymają tylko
+// indeksy. Analiza semantyczna zapisuje indeks w IdentifierNode::sym, więc
+// kolejne przebiegi sięgają po symbol wprost, bez szukania po nazwie.
+// deque: adresy SymbolInfo* są stałe przy dopisywaniu.
 class SymbolTable {
 public:
-    // Zostaje globalScope dla symboli globalnych
-    std::unordered_map<std::string, SymbolInfo> globalScope;
+    std::deque<SymbolInfo> symbols;
+
+    // Zostaje globalScope dla symboli globalnych: nazwa => indeks w symbols
+    std::unordered_map<Name, int> globalScope;
 
-    // Zamiast single 'currentScope' mamy mapę <nazwa_procedury, map<nazwa_symbolu, SymbolInfo>>
-    std::unordered_map<std::string, std::unordered_map<std::string, SymbolInfo>> localScopes;
+    // Zamiast single 'currentScope' mamy mapę <nazwa_procedury, map<nazwa_symbolu, indeks>>
+    std::unordered_map<Name, std::unordered_map<Name, int>> localScopes;
 
     int errors = 0;
+    std::ostream* diag = &std::cerr; ///< dokąd trafiają komunikaty o błędach (np. bufor pliku w trybie wsadowym)
 
     void reportError(const std::string &msg, uint64_t line) {
-        std::cerr << "Semantyczny błąd w linii " << line << ": " << msg << std::endl;
+        *diag << "Semantyczny błąd w linii " << line << ": " << msg << std::endl;
         errors++;
     }
 
+    SymbolInfo& at(int index) { return symbols[index]; }
+
     // -------------------------
     // Dodawanie do globalScope:
     // -------------------------
@@ -63,7 +75,7 @@ public:
             reportError("Druga deklaracja symbolu (global) \"" + info.name + "\"", line);
             return false;
         }
-        globalScope[info.name] = info;
+        globalScope[info.name] = store(info);
         return true;
     }
 
@@ -72,7 +84,7 @@ public:
     // --------------------------------------------
     bool addLocalSymbol(const SymbolInfo &info, uint64_t line) {
         // bierzemy ownerProcName z przekazanego info
-        const std::string &owner = info.ownerProcName;
+        Name owner = info.ownerProcName;
         auto &procMap = localScopes[owner]; 
         // sprawdzamy, czy w obrębie danej procedury nazwa jest wolna
         if (procMap.find(info.name) != procMap.end()) {
@@ -81,53 +93,50 @@ public:
             return false;
         }
         // wrzucamy do localScopes[owner][info.name]
-        procMap[info.name] = info;
+        procMap[info.name] = store(info);
         return true;
     }
 
-    // Metoda lookup bez podania nazwy procedury
-    // - sprawdza w localScopes[currentProcedure] i w globalu
-    SymbolInfo* lookup(const std::string &name, const std::string &currentProc) {
+    // Indeks symbolu widocznego w procedurze currentProc (lokalny, potem global); -1 => brak
+    int find(Name name, Name currentProc) const {
         // 1) localScopes[currentProc]
         auto itProc = localScopes.find(currentProc);
         if (itProc != localScopes.end()) {
-            auto &symMap = itProc->second;
-            auto itSym = symMap.find(name);
-            if (itSym != symMap.end()) {
-                return &itSym->second;
+            auto itSym = itProc->second.find(name);
+            if (itSym != itProc->second.end()) {
+                return itSym->second;
             }
         }
         // 2) globalScope
         auto itGlob = globalScope.find(name);
         if (itGlob != globalScope.end()) {
-            return &itGlob->second;
+            return itGlob->second;
         }
         // 3) brak
-        return nullptr;
+        return -1;
+    }
+
+    // Metoda lookup bez podania nazwy procedury
+    // - sprawdza w localScopes[currentProcedure] i w globalu
+    SymbolInfo* lookup(Name name, Name currentProc) {
+        int index = find(name, currentProc);
+        return index < 0 ? nullptr : &symbols[index];
+    }
+
+    // Symbol z indeksem zapisanym w węźle (IdentifierNode::sym), a bez niego po nazwie
+    SymbolInfo* resolve(int cached, Name name, Name currentProc) {
+        return cached >= 0 ? &symbols[cached] : lookup(name, currentProc);
     }
 
     // Używane, jeśli chcesz odwoływać się do symboli procedury innej niż currentProc:
     // (albo w semantyce, gdy "ownerProcName" jest w info)
-    SymbolInfo* lookupOwned(const std::string &name, const std::string &owner) {
-        // najpierw localScopes[owner]
-        auto itOwner = localScopes.find(owner);
-        if (itOwner != localScopes.end()) {
-            auto &symMap = itOwner->second;
-            auto itSym = symMap.find(name);
-            if (itSym != symMap.end()) {
-                return &itSym->second;
-            }
-        }
-        // jak nie ma => global
-        auto itGlob = globalScope.find(name);
-        if (itGlob != globalScope.end()) {
-            return &itGlob->second;
-        }
-        return nullptr;
+    SymbolInfo* lookupOwned(Name name, Name owner) {
+        return lookup(name, owner);
     }
 
-    // Dodatkowo, do for-iterator remove (jeśli chcesz usuwać):
-    bool removeLocalSymbol(const std::string &name, const std::string &owner) {
+    // Zdejmuje nazwę z zasięgu (iterator FOR po pętli); sam symbol zostaje w
+    // magazynie, bo wskazują na niego węzły z ciała pętli
+    bool removeLocalSymbol(Name name, Name owner) {
         auto itOwner = localScopes.find(owner);
         if (itOwner != localScopes.end()) {
             auto &symMap = itOwner->second;
@@ -144,6 +153,12 @@ public:
     void clearLocalScope() {
 
     }
+
+private:
+    int store(const SymbolInfo &info) {
+        symbols.push_back(info);
+        return (int)symbols.size() - 1;
+    }
 };
 
 #endif // SYMTABLE_HPP
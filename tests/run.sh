@@ -0,0 +1,162 @@
+#!/bin/bash
+# Testy: każdy tests/*.imp ma w komentarzach wejście i oczekiwane wyjście:
+#   # IN: liczby podawane na READ
+#   # OUT: liczby wypisane przez WRITE
+#   # FLAGS: opcje kompilatora (opcjonalnie)
+#   # BASE: dodatkowe opcje, zwykle wyłączające badany przebieg (opcjonalnie,
+#   #       może być kilka linii); program kompilowany także z nimi musi dać
+#   #       to samo OUT
+# "--profile-use=@" w FLAGS/BASE: profil z przebiegu --profile-gen na tym
+# samym wejściu (pełna droga zbierania i użycia profilu)
+# Na końcu wszystkie pliki jeszcze raz w trybie wsadowym i przez serwer
+# kompilacji (także po zmianie części procedur): kod ma być ten sam co
+# z kompilacji pojedynczej (bez FLAGS)
+# Uruchomienie: VM=ścieżka/do/maszyny-wirtualnej tests/run.sh [kompilator]
+KOMPILATOR=${1:-./kompilator}
+if [ -z "$VM" ]; then
+    echo "Podaj maszynę wirtualną: VM=... $0" >&2
+    exit 2
+fi
+
+dir=$(dirname "$0")
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+pass=0
+fail=0
+
+# check nazwa źródło wejście oczekiwane opcje...
+check() {
+    local name=$1 src=$2 in=$3 want=$4
+    shift 4
+    local args=() arg
+    for arg in "$@"; do
+        if [ "$arg" == "--profile-use=@" ]; then
+            if ! "$KOMPILATOR" "$src" "$tmp/$name.gen.mr" --profile-gen >"$tmp/$name.log" 2>&1; then
+                echo "BŁĄD $name --profile-gen: kompilacja"
+                fail=$((fail + 1))
+                return
+            fi
+            echo $in | "$VM" "$tmp/$name.gen.mr" >"$tmp/$name.prof" 2>/dev/null
+            arg="--profile-use=$tmp/$name.prof"
+        fi
+        args+=("$arg")
+    done
+    if ! "$KOMPILATOR" "$src" "$tmp/$name.mr" "${args[@]}" >"$tmp/$name.log" 2>&1; then
+        echo "BŁĄD $name $*: kompilacja"
+        fail=$((fail + 1))
+        return
+    fi
+    # wiersze "> liczba" (maszyna z zajęć) albo same liczby
+    local got
+    got=$(echo $in | "$VM" "$tmp/$name.mr" 2>/dev/null \
+          | sed -n 's/^\(.*> \)\{0,1\}\(-\{0,1\}[0-9][0-9]*\)$/\2/p' | xargs)
+    if [ "$got" == "$want" ]; then
+        pass=$((pass + 1))
+    else
+        echo "BŁĄD $name $*: oczekiwano \"$want\", jest \"$got\""
+        fail=$((fail + 1))
+    fi
+}
+
+for src in "$dir"/*.imp; do
+    name=$(basename "$src" .imp)
+    in=$(sed -n 's/^# IN://p' "$src")
+    want=$(sed -n 's/^# OUT://p' "$src" | xargs)
+    flags=$(sed -n 's/^# FLAGS://p' "$src")
+    check "$name" "$src" "$in" "$want" $flags
+    while read -r base; do
+        check "$name" "$src" "$in" "$want" $flags $base
+    done < <(sed -n 's/^# BASE://p' "$src")
+done
+
+# same opis katalog [wzorzec]: każdy tests/*.imp skompilowany do
+# katalog/nazwa.mr tak samo jak pojedynczo do wzorzec (domyślnie $tmp/one)
+same() {
+    local what=$1 out=$2 ref=${3:-$tmp/one} src name
+    for src in "$dir"/*.imp; do
+        name=$(basename "$src" .imp)
+        if cmp -s "$ref/$name.mr" "$out/$name.mr"; then
+            pass=$((pass + 1))
+        else
+            echo "BŁĄD $name $what: kod inny niż z kompilacji pojedynczej"
+            fail=$((fail + 1))
+        fi
+    done
+}
+
+mkdir -p "$tmp/one" "$tmp/batch" "$tmp/dir"
+: >"$tmp/manifest"
+for src in "$dir"/*.imp; do
+    name=$(basename "$src" .imp)
+    "$KOMPILATOR" "$src" "$tmp/one/$name.mr" >/dev/null 2>&1
+    echo "$src $tmp/batch/$name.mr" >>"$tmp/manifest"
+    cp "$src" "$tmp/dir/"
+done
+
+# Tryb wsadowy: manifest na kilku wątkach i cały katalog
+if ! "$KOMPILATOR" --batch="$tmp/manifest" --jobs=4 >"$tmp/batch.log" 2>&1; then
+    echo "BŁĄD --batch=manifest: $(tail -n 1 "$tmp/batch.log")"
+    fail=$((fail + 1))
+fi
+same "--batch=manifest" "$tmp/batch"
+if ! "$KOMPILATOR" --batch="$tmp/dir" >"$tmp/batch.log" 2>&1; then
+    echo "BŁĄD --batch=katalog: $(tail -n 1 "$tmp/batch.log")"
+    fail=$((fail + 1))
+fi
+same "--batch=katalog" "$tmp/dir"
+
+# Serwer: dwa przebiegi, drugi w całości z pamięci podręcznej wyników
+sock="$tmp/sock"
+"$KOMPILATOR" --server="$sock" >"$tmp/server.log" 2>&1 &
+server=$!
+for i in $(seq 50); do
+    [ -S "$sock" ] && break
+    sleep 0.1
+done
+# via przebieg katalog_źródeł: każdy plik przez --connect do $tmp/przebieg
+via() {
+    local run=$1 from=$2 src name
+    mkdir -p "$tmp/$run"
+    for src in "$from"/*.imp; do
+        name=$(basename "$src" .imp)
+        "$KOMPILATOR" --connect="$sock" "$src" "$tmp/$run/$name.mr" >/dev/null 2>"$tmp/$run.log"
+        if grep -q "Brak serwera" "$tmp/$run.log"; then
+            echo "BŁĄD $name --connect: serwer nie odpowiada"
+            fail=$((fail + 1))
+        fi
+    done
+}
+via srv1 "$dir"
+same "--connect" "$tmp/srv1"
+via srv2 "$dir"
+same "--connect (drugi raz)" "$tmp/srv2"
+# Plik zmieniony tylko częściowo (nowa procedura na początku przesuwa
+# pozostałe): reszta z pamięci podręcznej procedur, wynik jak lokalnie
+mkdir -p "$tmp/edit" "$tmp/one2"
+for src in "$dir"/*.imp; do
+    name=$(basename "$src" .imp)
+    { printf 'PROCEDURE zmiana(T a, n) IS\nBEGIN\n  a[n] := n + 1;\nEND\n'; cat "$src"; } >"$tmp/edit/$name.imp"
+    "$KOMPILATOR" "$tmp/edit/$name.imp" "$tmp/one2/$name.mr" >/dev/null 2>&1
+done
+via srv3 "$tmp/edit"
+same "--connect (zmieniony)" "$tmp/srv3" "$tmp/one2"
+"$KOMPILATOR" --connect="$sock" --stop-server >/dev/null 2>&1
+wait $server
+count=$(ls "$dir"/*.imp | wc -l)
+hits=$(sed -n 's/.*kompilacji, z pamięci podręcznej: \([0-9]*\).*/\1/p' "$tmp/server.log")
+if [ "$hits" == "$count" ]; then
+    pass=$((pass + 1))
+else
+    echo "BŁĄD --server: z pamięci podręcznej \"$hits\" z $count powtórzonych"
+    fail=$((fail + 1))
+fi
+procs=$(sed -n 's/.*procedur z pamięci podręcznej: \([0-9]*\).*/\1/p' "$tmp/server.log")
+if [ "${procs:-0}" -gt 0 ]; then
+    pass=$((pass + 1))
+else
+    echo "BŁĄD --server: żadna procedura zmienionych plików z pamięci podręcznej"
+    fail=$((fail + 1))
+fi
+
+echo "Testy: $pass OK, $fail błędów"
+[ $fail -eq 0 ]
@@ -0,0 +1,126 @@
+#include "thread_pool.hpp"
+
+#include <atomic>
+
+unsigned resolveThreads(unsigned requested) {
+    if (requested > 0) return requested;
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
+
+void parallelFor(size_t count, unsigned threads, const std::function<void(size_t)> &fn) {
+    threads = resolveThreads(threads);
+    if (threads > count) threads = (unsigned)count;
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; i++) fn(i);
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) fn(i);
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker(); // bieżący wątek też pracuje
+    for (auto &th : pool) th.join();
+}
+
+// ------------------ WorkStealingPool ------------------
+
+namespace {
+// Pula i numer kolejki bieżącego wątku (nullptr poza wątkami puli)
+thread_local WorkStealingPool* currentPool = nullptr;
+thread_local size_t currentQueue = 0;
+}
+
+WorkStealingPool::WorkStealingPool(unsigned threads) {
+    threads = resolveThreads(threads);
+    for (unsigned i = 0; i < threads; i++) queues.push_back(std::make_unique<Queue>());
+    for (unsigned i = 0; i < threads; i++) workers.emplace_back([this, i]() { run(i); });
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lk(stateMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &th : workers) th.join();
+}
+
+void WorkStealingPool::submit(Task task) {
+    size_t target;
+    {
+        std::lock_guard<std::mutex> lk(stateMutex);
+        pending++;
+        if (currentPool == this) {
+            target = currentQueue;
+        } else {
+            target = nextQueue;
+            nextQueue = (nextQueue + 1) % queues.size();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lk(queues[target]->m);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    // `queued` rośnie dopiero, gdy zadanie już leży w kolejce: obudzony wątek na pewno je znajdzie
+    {
+        std::lock_guard<std::mutex> lk(stateMutex);
+        queued++;
+    }
+    wake.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lk(stateMutex);
+    idle.wait(lk, [this]() { return pending == 0; });
+}
+
+bool WorkStealingPool::tryTake(size_t self, Task &out) {
+    // Najpierw własna kolejka od końca (najświeższe zadanie)
+    {
+        Queue &q = *queues[self];
+        std::lock_guard<std::mutex> lk(q.m);
+        if (!q.tasks.empty()) {
+            out = std::move(q.tasks.back());
+            q.tasks.pop_back();
+            return true;
+        }
+    }
+    // Potem podkradamy z początku cudzych, zaczynając od sąsiada
+    for (size_t k = 1; k < queues.size(); k++) {
+        Queue &q = *queues[(self + k) % queues.size()];
+        std::lock_guard<std::mutex> lk(q.m);
+        if (!q.tasks.empty()) {
+            out = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::run(size_t self) {
+    currentPool = this;
+    currentQueue = self;
+    for (;;) {
+        Task task;
+        if (tryTake(self, task)) {
+            {
+                std::lock_guard<std::mutex> lk(stateMutex);
+                queued--;
+            }
+            task();
+            task = nullptr; // zasoby zadania zwalniamy przed zgłoszeniem końca
+            std::lock_guard<std::mutex> lk(stateMutex);
+            if (--pending == 0) idle.notify_all();
+            continue;
+        }
+        std::unique_lock<std::mutex> lk(stateMutex);
+        wake.wait(lk, [this]() { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////
+// Równoległe wykonanie niezależnych zadań
+//////////////////////////////////////
+//
+// fn(0), ..., fn(count - 1) na co najwyżej `threads` wątkach (0 => liczba
+// rdzeni, 1 => w bieżącym wątku). Zadania pobierane po kolei ze wspólnego
+// licznika, więc krótkie i długie wyrównują się same. Wraca po wykonaniu
+// wszystkich.
+void parallelFor(size_t count, unsigned threads, const std::function<void(size_t)> &fn);
+
+// Liczba wątków dla `requested` (0 => liczba rdzeni, co najmniej 1)
+unsigned resolveThreads(unsigned requested);
+
+//////////////////////////////////////
+// Pula wątków z podkradaniem zadań
+//////////////////////////////////////
+//
+// Każdy wątek ma własną kolejkę: swoje zadania bierze od końca, a gdy jest
+// pusta, podkrada z początku cudzych. Zadania zgłaszane z zewnątrz trafiają
+// do kolejek po kolei, zgłaszane z wnętrza zadania — do kolejki bieżącego
+// wątku. Nadaje się do wielu zadań o bardzo różnym czasie (kompilacja
+// wsadowa), gdzie parallelFor wymagałby znajomości liczby zadań z góry.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(unsigned threads); ///< 0 => liczba rdzeni
+    ~WorkStealingPool();                         ///< czeka na zgłoszone zadania
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    void submit(Task task);
+    void wait(); ///< do zakończenia wszystkich zgłoszonych zadań
+    unsigned size() const { return (unsigned)workers.size(); }
+
+private:
+    struct Queue {
+        std::mutex m;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues; ///< kolejka i-tego wątku
+    std::vector<std::thread> workers;
+
+    std::mutex stateMutex;          ///< chroni liczniki i `stopping`
+    std::condition_variable wake;   ///< są zadania w kolejkach albo koniec
+    std::condition_variable idle;   ///< pending == 0
+    long queued = 0;                ///< zadania czekające w kolejkach
+    long pending = 0;               ///< zadania zgłoszone, niezakończone
+    bool stopping = false;
+    size_t nextQueue = 0;           ///< cel kolejnego zgłoszenia z zewnątrz
+
+    bool tryTake(size_t self, Task &out);
+    void run(size_t self);
+};
+
+#endif // THREAD_POOL_HPP